@@ -0,0 +1,95 @@
+/*********************                                                        */
+/*! \file ArrayView.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __ArrayView_h__
+#define __ArrayView_h__
+
+#include "Debug.h"
+
+#include <stdint.h>
+
+/*
+  A read-only view of a contiguous array that is owned elsewhere.
+  Copying a view never copies the elements.
+*/
+template<typename T>
+class ArrayView
+{
+public:
+    typedef const T *const_iterator;
+
+    ArrayView()
+        : _data( NULL )
+        , _size( 0 )
+    {
+    }
+
+    ArrayView( const T *data, uint64_t size )
+        : _data( data )
+        , _size( size )
+    {
+    }
+
+    const T &operator[]( uint64_t index ) const
+    {
+        ASSERT( index < _size );
+        return _data[index];
+    }
+
+    const T *data() const
+    {
+        return _data;
+    }
+
+    uint64_t size() const
+    {
+        return _size;
+    }
+
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    const_iterator begin() const
+    {
+        return _data;
+    }
+
+    const_iterator end() const
+    {
+        return _data + _size;
+    }
+
+    /*
+      A view of the elements [start, start + size).
+    */
+    ArrayView<T> slice( uint64_t start, uint64_t size ) const
+    {
+        ASSERT( start + size <= _size );
+        return ArrayView<T>( _data + start, size );
+    }
+
+private:
+    const T *_data;
+    uint64_t _size;
+};
+
+#endif // __ArrayView_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -12,35 +12,124 @@
  **/
 
 #include "BasisFactorization.h"
+#include "CommonError.h"
 #include "Debug.h"
 #include "EtaMatrix.h"
 #include "FloatUtils.h"
 #include "GlobalConfiguration.h"
+#include "HashUtils.h"
+#include "InverseRowCache.h"
 #include "LPElement.h"
 #include "MStringf.h"
+#include "OperationTimers.h"
+#include "PerfCounters.h"
+#include "Probes.h"
 #include "ReluplexError.h"
+#include "SparseColumnMatrix.h"
+#include "ThreadPool.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    /*
+      Fires the entry probe of a transformation when constructed, and
+      the return probe when destroyed, with the dimension and the
+      nonzeros of the input and the output.
+    */
+    class TransformationProbe
+    {
+    public:
+        TransformationProbe( bool forward, const double *y, const double *x, unsigned m )
+            : _forward( forward )
+            , _x( x )
+            , _m( m )
+        {
+            if ( _forward && MARABOU_PROBE_ENABLED( ftran__entry ) )
+                MARABOU_PROBE2( ftran__entry, _m, OperationTimers::countNonZeros( y, _m ) );
+            else if ( !_forward && MARABOU_PROBE_ENABLED( btran__entry ) )
+                MARABOU_PROBE2( btran__entry, _m, OperationTimers::countNonZeros( y, _m ) );
+        }
+
+        ~TransformationProbe()
+        {
+            if ( _forward && MARABOU_PROBE_ENABLED( ftran__return ) )
+                MARABOU_PROBE2( ftran__return, _m, OperationTimers::countNonZeros( _x, _m ) );
+            else if ( !_forward && MARABOU_PROBE_ENABLED( btran__return ) )
+                MARABOU_PROBE2( btran__return, _m, OperationTimers::countNonZeros( _x, _m ) );
+        }
+
+    private:
+        bool _forward;
+        const double *_x;
+        unsigned _m;
+    };
+
+    /*
+      The columns of a basis, read from the constraint matrix.
+    */
+    class BasisView : public BasisFactorization::ColumnOracle
+    {
+    public:
+        BasisView( const SparseColumnMatrix *matrix, const unsigned *basicColumns )
+            : _matrix( matrix )
+            , _basicColumns( basicColumns )
+        {
+        }
+
+        unsigned getColumn( unsigned column, unsigned *rowIndices, double *values ) const
+        {
+            return _matrix->getColumn( _basicColumns[column], rowIndices, values );
+        }
+
+    private:
+        const SparseColumnMatrix *_matrix;
+        const unsigned *_basicColumns;
+    };
+}
+
+BasisFactorization::CompressedColumns::CompressedColumns( const unsigned *columnStart,
+                                                         const unsigned *rowIndices,
+                                                         const double *values )
+    : _columnStart( columnStart )
+    , _rowIndices( rowIndices )
+    , _values( values )
+{
+}
+
+unsigned BasisFactorization::CompressedColumns::getColumn( unsigned column, unsigned *rowIndices, double *values ) const
+{
+    unsigned start = _columnStart[column];
+    unsigned count = _columnStart[column + 1] - start;
+
+    memcpy( rowIndices, _rowIndices + start, sizeof(unsigned) * count );
+    memcpy( values, _values + start, sizeof(double) * count );
+    return count;
+}
 
 BasisFactorization::BasisFactorization( unsigned m )
     : _B0( NULL )
+    , _B0IsIdentity( true )
 	, _m( m )
     , _U( NULL )
+    , _pool( m )
+    , _rowCache( m )
     , _factorizationEnabled( true )
+    , _refactorizationThreshold( GlobalConfiguration::REFACTORIZATION_THRESHOLD )
+    , _constraintMatrix( NULL )
+    , _basicColumns( NULL )
+    , _currentBasicColumns( NULL )
     , _tempY( NULL )
     , _LCol( NULL )
+    , _leavingRow( NULL )
+    , _rowIndices( NULL )
+    , _workspace( NULL )
 {
-    _B0 = new double[m*m];
-    if ( !_B0 )
-        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BasisFactorization::B0" );
-
-    // Initialize B0 to the identity matrix
-    std::fill_n( _B0, _m * _m, 0.0 );
-    for ( unsigned row = 0; row < _m; ++row )
-        _B0[row * _m + row] = 1.0;
-
-	_U = new double[m*m];
-	if ( !_U )
-        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BasisFactorization::U" );
-
+    // B0 starts out as the identity matrix. It and U are only
+    // allocated once needed.
     _tempY = new double[m];
     if ( !_tempY )
         throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BasisFactorization::tempY" );
@@ -48,6 +137,14 @@ BasisFactorization::BasisFactorization( unsigned m )
     _LCol = new double[m];
     if ( !_LCol )
         throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BasisFactorization::LCol" );
+
+    _leavingRow = new double[m];
+    if ( !_leavingRow )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BasisFactorization::leavingRow" );
+
+    _rowIndices = new unsigned[m];
+    if ( !_rowIndices )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BasisFactorization::rowIndices" );
 }
 
 BasisFactorization::~BasisFactorization()
@@ -81,6 +178,38 @@ void BasisFactorization::freeIfNeeded()
         _LCol = NULL;
     }
 
+    if ( _leavingRow )
+    {
+        delete[] _leavingRow;
+        _leavingRow = NULL;
+    }
+
+    if ( _rowIndices )
+    {
+        delete[] _rowIndices;
+        _rowIndices = NULL;
+    }
+
+    if ( _workspace )
+    {
+        delete[] _workspace;
+        _workspace = NULL;
+    }
+
+    if ( _basicColumns )
+    {
+        delete[] _basicColumns;
+        _basicColumns = NULL;
+    }
+
+    if ( _currentBasicColumns )
+    {
+        delete[] _currentBasicColumns;
+        _currentBasicColumns = NULL;
+    }
+
+    _constraintMatrix = NULL;
+
     List<EtaMatrix *>::iterator it;
     for ( it = _etas.begin(); it != _etas.end(); ++it )
         delete *it;
@@ -92,6 +221,9 @@ void BasisFactorization::freeIfNeeded()
         delete *element;
 
 	_LP.clear();
+
+    _pool.clear();
+    _rowCache.freeIfNeeded();
 }
 
 const double *BasisFactorization::getU() const
@@ -99,31 +231,191 @@ const double *BasisFactorization::getU() const
 	return _U;
 }
 
-const List<LPElement *> BasisFactorization::getLP() const
+unsigned BasisFactorization::getUSize() const
+{
+    return _m * ( _m - 1 ) / 2;
+}
+
+const List<LPElement *> &BasisFactorization::getLP() const
 {
 	return _LP;
 }
 
 const double *BasisFactorization::getB0() const
 {
+    allocateB0();
+
+    // A basis view is materialized on every call
+    if ( _constraintMatrix )
+        scatterColumns( BasisView( _constraintMatrix, _basicColumns ), _B0 );
+
 	return _B0;
 }
 
-const List<EtaMatrix *> BasisFactorization::getEtas() const
+bool BasisFactorization::isB0Identity() const
+{
+    return _B0IsIdentity;
+}
+
+void BasisFactorization::allocateB0() const
+{
+    if ( _B0 )
+        return;
+
+    _B0 = new double[_m * _m];
+    if ( !_B0 )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BasisFactorization::B0" );
+
+    if ( !_B0IsIdentity )
+        return;
+
+    std::fill_n( _B0, _m * _m, 0.0 );
+    for ( unsigned row = 0; row < _m; ++row )
+        _B0[row * _m + row] = 1.0;
+}
+
+void BasisFactorization::setBasis( const SparseColumnMatrix *matrix, const unsigned *basicColumns )
+{
+    ASSERT( matrix->getNumRows() == _m );
+
+    if ( !_basicColumns )
+    {
+        _basicColumns = new unsigned[_m];
+        if ( !_basicColumns )
+            throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BasisFactorization::basicColumns" );
+    }
+
+    if ( !_currentBasicColumns )
+    {
+        _currentBasicColumns = new unsigned[_m];
+        if ( !_currentBasicColumns )
+            throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BasisFactorization::currentBasicColumns" );
+    }
+
+    for ( const auto &eta : _etas )
+        _pool.releaseEta( eta );
+    _etas.clear();
+
+    // The dense B0 is no longer needed
+    if ( _B0 )
+    {
+        delete[] _B0;
+        _B0 = NULL;
+    }
+
+    memcpy( _basicColumns, basicColumns, sizeof(unsigned) * _m );
+    memcpy( _currentBasicColumns, basicColumns, sizeof(unsigned) * _m );
+    _constraintMatrix = matrix;
+    _B0IsIdentity = false;
+
+    factorizeMatrix( BasisView( _constraintMatrix, _basicColumns ) );
+}
+
+const unsigned *BasisFactorization::getBasicColumns() const
+{
+    return _constraintMatrix ? _currentBasicColumns : NULL;
+}
+
+void BasisFactorization::releaseBasisView()
+{
+    _constraintMatrix = NULL;
+}
+
+void BasisFactorization::materializeBasisView()
+{
+    if ( !_constraintMatrix )
+        return;
+
+    allocateB0();
+    scatterColumns( BasisView( _constraintMatrix, _basicColumns ), _B0 );
+    releaseBasisView();
+}
+
+void BasisFactorization::factorizeB0()
+{
+    if ( _constraintMatrix )
+        factorizeMatrix( BasisView( _constraintMatrix, _basicColumns ) );
+    else
+        factorizeMatrix( _B0 );
+}
+
+void BasisFactorization::resetToIdentity()
+{
+    for ( const auto &eta : _etas )
+        _pool.releaseEta( eta );
+    _etas.clear();
+    clearLPU();
+    releaseBasisView();
+
+    if ( _B0 && !_B0IsIdentity )
+    {
+        std::fill_n( _B0, _m * _m, 0.0 );
+        for ( unsigned row = 0; row < _m; ++row )
+            _B0[row * _m + row] = 1.0;
+    }
+
+    _B0IsIdentity = true;
+}
+
+const List<EtaMatrix *> &BasisFactorization::getEtas() const
 {
 	return _etas;
 }
 
 void BasisFactorization::pushEtaMatrix( unsigned columnIndex, double *column )
 {
-    EtaMatrix *matrix = new EtaMatrix( _m, columnIndex, column );
+    // Without the entering column, a basis view can no longer follow
+    // the basis
+    materializeBasisView();
+    appendEta( columnIndex, column );
+}
+
+void BasisFactorization::pushEtaMatrix( unsigned columnIndex, double *column, unsigned enteringColumn )
+{
+    if ( _constraintMatrix )
+    {
+        ASSERT( enteringColumn < _constraintMatrix->getNumColumns() );
+        _currentBasicColumns[columnIndex] = enteringColumn;
+    }
+
+    appendEta( columnIndex, column );
+}
+
+void BasisFactorization::appendEta( unsigned columnIndex, double *column )
+{
+    OperationTimers::Scope timer( OperationTimers::PUSH_ETA, column, _m );
+
+    if ( MARABOU_PROBE_ENABLED( eta__push ) )
+        MARABOU_PROBE3( eta__push, _m, columnIndex, OperationTimers::countNonZeros( column, _m ) );
+
+    bool refactorize = ( _etas.size() + 1 > _refactorizationThreshold ) && _factorizationEnabled;
+
+    // Refactorizing drops the cached rows, so they are only updated if
+    // they survive the push
+    if ( !refactorize && !_rowCache.empty() )
+    {
+        const double *leavingRow = _rowCache.peek( columnIndex );
+        if ( !leavingRow )
+        {
+            std::fill_n( _LCol, _m, 0.0 );
+            _LCol[columnIndex] = 1.0;
+            backwardTransformation( _LCol, _leavingRow );
+            _rowCache.countUpdateTransformation();
+            leavingRow = _leavingRow;
+        }
+
+        _rowCache.update( columnIndex, column, leavingRow );
+    }
+
+    EtaMatrix *matrix = _pool.allocateEta( columnIndex, column );
     _etas.append( matrix );
 
-	if ( ( _etas.size() > GlobalConfiguration::REFACTORIZATION_THRESHOLD ) && _factorizationEnabled )
+	if ( refactorize )
 	{
         log( "Number of etas exceeds threshold. Condensing and refactoring\n" );
+        MARABOU_PROBE2( refactorize, _m, _etas.size() );
 		condenseEtas();
-		factorizeMatrix( _B0 );
+		factorizeB0();
 	}
 }
 
@@ -157,12 +449,55 @@ void BasisFactorization::LMultiplyLeft( const EtaMatrix *L, double *X ) const
 
 void BasisFactorization::setB0( const double *B0 )
 {
+    releaseBasisView();
+    _B0IsIdentity = false;
+    allocateB0();
 	memcpy( _B0, B0, sizeof(double) * _m * _m );
 	factorizeMatrix( _B0 );
 }
 
+void BasisFactorization::setB0( const unsigned *columnStart, const unsigned *rowIndices, const double *values )
+{
+    setB0( CompressedColumns( columnStart, rowIndices, values ) );
+}
+
+void BasisFactorization::setB0( const ColumnOracle &oracle )
+{
+    releaseBasisView();
+    _B0IsIdentity = false;
+    allocateB0();
+    scatterColumns( oracle, _B0 );
+	factorizeMatrix( _B0 );
+}
+
 void BasisFactorization::condenseEtas()
 {
+    TRACE_SCOPE( "condense", "factorization" );
+    OperationTimers::Scope timer( OperationTimers::CONDENSE, _constraintMatrix ? NULL : _B0, _m * _m );
+
+    // With a basis view, the etas have already been applied to the
+    // basic columns
+    if ( _constraintMatrix )
+    {
+        for ( const auto &eta : _etas )
+            _pool.releaseEta( eta );
+        _etas.clear();
+
+        memcpy( _basicColumns, _currentBasicColumns, sizeof(unsigned) * _m );
+        clearLPU();
+        return;
+    }
+
+    if ( _etas.empty() )
+    {
+        clearLPU();
+        return;
+    }
+
+    allocateB0();
+    _B0IsIdentity = false;
+    timer.setOutput( _B0, _m * _m );
+
     // Multiplication by an eta matrix on the right only changes one
     // column of B0. The new column is a linear combination of the
     // existing columns of B0, according to the eta column. We perform
@@ -185,7 +520,7 @@ void BasisFactorization::condenseEtas()
             _B0[i * _m + col] = sum;
 		}
 
-		delete eta;
+		_pool.releaseEta( eta );
 	}
 
 	_etas.clear();
@@ -194,6 +529,11 @@ void BasisFactorization::condenseEtas()
 
 void BasisFactorization::forwardTransformation( const double *y, double *x ) const
 {
+    PERF_COUNTER_SCOPE( PerfCounters::FORWARD_TRANSFORMATION );
+    OperationTimers::Scope timer( OperationTimers::FORWARD_TRANSFORMATION, y, _m );
+    timer.setOutput( x, _m );
+    TransformationProbe probe( true, y, x, _m );
+
     // If there's no LP factorization, it is implied that B0 = I.
     // Then, because there are no etas, x = y.
     if ( _etas.empty() && _LP.empty() )
@@ -228,9 +568,12 @@ void BasisFactorization::forwardTransformation( const double *y, double *x ) con
 		x[_m-1] = _tempY[_m-1];
 		for ( int i = _m - 2; i >= 0; --i )
         {
+            // Row i of U, from column i + 1 onwards
+            const double *uRow = _U + getUIndex( i, i + 1 );
+
 			double sum = 0;
 			for ( int j = _m - 1; j > i; --j )
-				sum += _U[i * _m + j] * x[j];
+				sum += uRow[j - i - 1] * x[j];
 			x[i] = _tempY[i] - sum;
 
             if ( FloatUtils::isZero( x[i] ) )
@@ -270,6 +613,11 @@ void BasisFactorization::forwardTransformation( const double *y, double *x ) con
 
 void BasisFactorization::backwardTransformation( const double *y, double *x ) const
 {
+    PERF_COUNTER_SCOPE( PerfCounters::BACKWARD_TRANSFORMATION );
+    OperationTimers::Scope timer( OperationTimers::BACKWARD_TRANSFORMATION, y, _m );
+    timer.setOutput( x, _m );
+    TransformationProbe probe( false, y, x, _m );
+
     // If there's no LP factorization, it is implied that B0 = I.
     // Then, because there are no etas, x = y.
     if ( _etas.empty() && _LP.empty() )
@@ -312,18 +660,22 @@ void BasisFactorization::backwardTransformation( const double *y, double *x ) co
 
     // Next step is to eliminate U by setting x'= x*inv(LP), solving x'*U = y,
     // and storing the solution for x' in x.
+    // U is stored by rows, so once an entry of x' is known, subtract
+    // its contribution from the remaining entries of y along its row.
 	if ( !_LP.empty() )
 	{
-		x[0] = _tempY[0];
-		for ( unsigned i = 1; i < _m; ++i )
+		for ( unsigned j = 0; j < _m; ++j )
         {
-			double sum = 0;
-			for ( unsigned j = 0; j < i; ++j )
-				sum += _U[i + j * _m] * x[j];
-			x[i] = _tempY[i] - sum;
+            x[j] = _tempY[j];
+            if ( FloatUtils::isZero( x[j] ) )
+            {
+                x[j] = 0.0;
+                continue;
+            }
 
-            if ( FloatUtils::isZero( x[i] ) )
-                x[i] = 0.0;
+            const double *uRow = _U + getUIndex( j, j + 1 );
+			for ( unsigned i = j + 1; i < _m; ++i )
+				_tempY[i] -= uRow[i - j - 1] * x[j];
 		}
 	}
 
@@ -344,6 +696,42 @@ void BasisFactorization::backwardTransformation( const double *y, double *x ) co
 	}
 }
 
+void BasisFactorization::getInverseRow( unsigned row, double *result )
+{
+    ASSERT( row < _m );
+
+    if ( _rowCache.getCapacity() == 0 )
+    {
+        std::fill_n( _LCol, _m, 0.0 );
+        _LCol[row] = 1.0;
+        backwardTransformation( _LCol, result );
+        return;
+    }
+
+    const double *cached = _rowCache.find( row );
+    if ( !cached )
+    {
+        std::fill_n( _LCol, _m, 0.0 );
+        _LCol[row] = 1.0;
+
+        double *slot = _rowCache.insert( row );
+        backwardTransformation( _LCol, slot );
+        cached = slot;
+    }
+
+    memcpy( result, cached, sizeof(double) * _m );
+}
+
+const InverseRowCache &BasisFactorization::getInverseRowCache() const
+{
+    return _rowCache;
+}
+
+void BasisFactorization::setInverseRowCacheCapacity( unsigned capacity )
+{
+    _rowCache.setCapacity( capacity );
+}
+
 void BasisFactorization::rowSwap( unsigned rowOne, unsigned rowTwo, double *matrix )
 {
     double temp = 0;
@@ -359,17 +747,79 @@ void BasisFactorization::clearLPU()
 {
     List<LPElement *>::iterator element;
     for ( element = _LP.begin(); element != _LP.end(); ++element )
-        delete *element;
+        _pool.releaseElement( *element );
 	_LP.clear();
 
-	std::fill_n( _U, _m*_m, 0 );
+    if ( _U )
+        std::fill_n( _U, getUSize(), 0 );
+
+    // Whatever replaces the factorization, the cached rows are stale
+    _rowCache.invalidate();
 }
 
 void BasisFactorization::factorizeMatrix( double *matrix )
 {
-    // Clear any previous factorization, initialize U
+    allocateWorkspace();
+	memcpy( _workspace, matrix, sizeof(double) * _m * _m );
+    factorizeWorkspace();
+}
+
+void BasisFactorization::factorizeMatrix( const unsigned *columnStart, const unsigned *rowIndices, const double *values )
+{
+    factorizeMatrix( CompressedColumns( columnStart, rowIndices, values ) );
+}
+
+void BasisFactorization::factorizeMatrix( const ColumnOracle &oracle )
+{
+    allocateWorkspace();
+    scatterColumns( oracle, _workspace );
+    factorizeWorkspace();
+}
+
+void BasisFactorization::allocateWorkspace()
+{
+    if ( _workspace )
+        return;
+
+    _workspace = new double[_m * _m];
+    if ( !_workspace )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BasisFactorization::workspace" );
+}
+
+void BasisFactorization::scatterColumns( const ColumnOracle &oracle, double *matrix ) const
+{
+    std::fill_n( matrix, _m * _m, 0.0 );
+
+    for ( unsigned column = 0; column < _m; ++column )
+    {
+        unsigned count = oracle.getColumn( column, _rowIndices, _LCol );
+        ASSERT( count <= _m );
+
+        for ( unsigned i = 0; i < count; ++i )
+        {
+            ASSERT( _rowIndices[i] < _m );
+            matrix[_rowIndices[i] * _m + column] = _LCol[i];
+        }
+    }
+}
+
+void BasisFactorization::factorizeWorkspace()
+{
+    PERF_COUNTER_SCOPE( PerfCounters::FACTORIZE );
+    TRACE_SCOPE( "refactorization", "factorization" );
+    OperationTimers::Scope timer( OperationTimers::FACTORIZE, _workspace, _m * _m );
+
+    if ( !_U )
+    {
+        _U = new double[getUSize()];
+        if ( !_U )
+            throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BasisFactorization::U" );
+    }
+
+    timer.setOutput( _U, getUSize() );
+
+    // Clear any previous factorization
 	clearLPU();
-	memcpy( _U, matrix, sizeof(double) * _m * _m );
 
 	for ( unsigned i = 0; i < _m; ++i )
     {
@@ -377,12 +827,12 @@ void BasisFactorization::factorizeMatrix( double *matrix )
         // Employ partial pivoting: find the row with the largest element and swap it to position i
         // (See discussion at http://www2.lawrence.edu/fast/GREGGJ/Math420/Section_6_2.pdf)
 
-        double largestElement = FloatUtils::abs( _U[i * _m + i] );
+        double largestElement = FloatUtils::abs( _workspace[i * _m + i] );
         unsigned bestRowIndex = i;
 
         for ( unsigned j = i + 1; j < _m; ++j )
         {
-            double contender = FloatUtils::abs( _U[j * _m + i] );
+            double contender = FloatUtils::abs( _workspace[j * _m + i] );
             if ( FloatUtils::gt( contender, largestElement ) )
             {
                 largestElement = contender;
@@ -397,46 +847,49 @@ void BasisFactorization::factorizeMatrix( double *matrix )
         // Swap rows i and bestRow (if needed), and store this permutation
         if ( bestRowIndex != i )
         {
-            rowSwap( i, bestRowIndex, _U );
-            std::pair<unsigned, unsigned> *P = new std::pair<unsigned, unsigned>( i, bestRowIndex );
-            _LP.appendHead( new LPElement( NULL, P ) );
+            rowSwap( i, bestRowIndex, _workspace );
+            _LP.appendHead( _pool.allocatePermutationElement( i, bestRowIndex ) );
         }
 
         // The matrix now has a non-zero value at entry (i,i), so we can perform
         // Gaussian elimination for the subsequent rows
         std::fill_n( _LCol, _m, 0 );
-        double div = _U[i * _m + i];
+        double div = _workspace[i * _m + i];
         _LCol[i] = 1 / div;
 		for ( unsigned j = i + 1; j < _m; ++j )
-            _LCol[j] = -_U[i + j * _m] / div;
+            _LCol[j] = -_workspace[i + j * _m] / div;
 
         // Store the resulting lower-triangular eta matrix
-        EtaMatrix *L = new EtaMatrix( _m, i, _LCol );
-        _LP.appendHead( new LPElement( L, NULL ) );
+        LPElement *L = _pool.allocateEtaElement( i, _LCol );
+        _LP.appendHead( L );
 
         // Perform the actual elimination step on U
-        LFactorizationMultiply( L );
+        LFactorizationMultiply( L->_eta, _workspace );
 	}
+
+    // Pack the strictly upper triangular part; the diagonal is all ones
+    for ( unsigned row = 0; row + 1 < _m; ++row )
+        memcpy( _U + getUIndex( row, row + 1 ), _workspace + row * _m + row + 1, sizeof(double) * ( _m - row - 1 ) );
 }
 
-void BasisFactorization::LFactorizationMultiply( const EtaMatrix *L )
+void BasisFactorization::LFactorizationMultiply( const EtaMatrix *L, double *matrix ) const
 {
     unsigned colIndex = L->_columnIndex;
     // First, perform in-place multiplication for all rows below the pivot row
     for ( unsigned row = colIndex + 1; row < _m; ++row )
     {
-        _U[row * _m + colIndex] = 0.0;
+        matrix[row * _m + colIndex] = 0.0;
         for ( unsigned col = colIndex + 1; col < _m; ++col )
-            _U[row * _m + col] += L->_column[row] * _U[colIndex * _m + col];
+            matrix[row * _m + col] += L->_column[row] * matrix[colIndex * _m + col];
     }
 
     // Finally, perform the multiplication for the pivot row
     // itself. We change this row last because it is required for all
     // previous multiplication operations.
 	for ( unsigned i = colIndex + 1; i < _m; ++i )
-		_U[colIndex * _m + i] *= L->_column[colIndex];
+		matrix[colIndex * _m + i] *= L->_column[colIndex];
 
-    _U[colIndex * _m + colIndex] = 1.0;
+    matrix[colIndex * _m + colIndex] = 1.0;
 }
 
 void BasisFactorization::matrixMultiply( unsigned dimension, const double *left, const double *right, double *result )
@@ -464,17 +917,46 @@ void BasisFactorization::toggleFactorization( bool value )
     _factorizationEnabled = value;
 }
 
+unsigned BasisFactorization::getRefactorizationThreshold() const
+{
+    return _refactorizationThreshold;
+}
+
+void BasisFactorization::setRefactorizationThreshold( unsigned threshold )
+{
+    _refactorizationThreshold = threshold;
+}
+
 void BasisFactorization::storeFactorization( BasisFactorization *other )
 {
     ASSERT( _m == other->_m );
     ASSERT( other->_etas.size() == 0 );
 
+    TRACE_SCOPE( "store", "factorization" );
+    OperationTimers::Scope timer( OperationTimers::STORE, _constraintMatrix ? NULL : _B0, _m * _m );
+
     // In order to reduce space requirements, condense the etas before storing a factorization
     condenseEtas();
-    factorizeMatrix( _B0 );
+
+    // An identity B0 is stored as such, without copying it
+    if ( _B0IsIdentity )
+    {
+        other->resetToIdentity();
+        return;
+    }
+
+    factorizeB0();
+
+    // A basis view is stored as its basic columns
+    if ( _constraintMatrix )
+    {
+        other->setBasis( _constraintMatrix, _basicColumns );
+        return;
+    }
 
     // Now we simply store _B0
     other->setB0( _B0 );
+    timer.setOutput( other->_B0, _m * _m );
 }
 
 void BasisFactorization::restoreFactorization( const BasisFactorization *other )
@@ -482,82 +964,567 @@ void BasisFactorization::restoreFactorization( const BasisFactorization *other )
     ASSERT( _m == other->_m );
     ASSERT( other->_etas.size() == 0 );
 
+    TRACE_SCOPE( "restore", "factorization" );
+    OperationTimers::Scope timer( OperationTimers::RESTORE, other->_constraintMatrix ? NULL : other->_B0, _m * _m );
+
+    if ( other->_B0IsIdentity )
+    {
+        resetToIdentity();
+        return;
+    }
+
+    if ( other->_constraintMatrix )
+    {
+        setBasis( other->_constraintMatrix, other->_basicColumns );
+        return;
+    }
+
     // Clear any existing data
     for ( const auto &it : _etas )
-        delete it;
+        _pool.releaseEta( it );
 
     _etas.clear();
 	clearLPU();
 
     // Store the new B0 and LU-factorize it
     setB0( other->_B0 );
+    timer.setOutput( _B0, _m * _m );
+}
+
+namespace
+{
+    const uint32_t FACTORIZATION_MAGIC = 0x4642424d; // "MBBF"
+    const uint32_t FACTORIZATION_VERSION = 1;
+
+    enum LPElementKind {
+        LP_ELEMENT_PERMUTATION = 0,
+        LP_ELEMENT_ETA = 1,
+    };
+
+    struct FactorizationFileHeader
+    {
+        uint32_t _magic;
+        uint32_t _version;
+        uint32_t _m;
+        uint32_t _hasFactors;
+        uint64_t _payloadSize;
+        uint64_t _checksum;
+    };
+
+    template<typename T>
+    void appendToBuffer( std::vector<char> &buffer, T value )
+    {
+        const char *bytes = (const char *)&value;
+        buffer.insert( buffer.end(), bytes, bytes + sizeof(T) );
+    }
+
+    /*
+      Reads values from a payload, failing (rather than reading past
+      the end) on truncated data.
+    */
+    class PayloadReader
+    {
+    public:
+        PayloadReader( const std::vector<char> &buffer )
+            : _buffer( buffer )
+            , _offset( 0 )
+        {
+        }
+
+        template<typename T>
+        bool read( T &value )
+        {
+            if ( _buffer.size() - _offset < sizeof(T) )
+                return false;
+
+            memcpy( &value, _buffer.data() + _offset, sizeof(T) );
+            _offset += sizeof(T);
+            return true;
+        }
+
+        bool atEnd() const
+        {
+            return _offset == _buffer.size();
+        }
+
+    private:
+        const std::vector<char> &_buffer;
+        uint64_t _offset;
+    };
+}
+
+void BasisFactorization::saveToFile( const String &path, const unsigned *basicVariables, bool includeFactors )
+{
+    if ( !_etas.empty() )
+    {
+        condenseEtas();
+        factorizeB0();
+    }
+
+    bool hasFactors = includeFactors && !_LP.empty();
+    std::vector<char> payload;
+
+    // Materializes an implicit identity or a basis view
+    getB0();
+
+    // Basic column identities
+    for ( unsigned i = 0; i < _m; ++i )
+        appendToBuffer<uint32_t>( payload, basicVariables[i] );
+
+    // B0, as (row, column, value) triplets. Entries are kept exactly,
+    // so that the stored factors still factor it after loading.
+    uint64_t nnz = 0;
+    for ( unsigned i = 0; i < _m * _m; ++i )
+        if ( _B0[i] != 0.0 )
+            ++nnz;
+
+    appendToBuffer<uint64_t>( payload, nnz );
+    for ( unsigned row = 0; row < _m; ++row )
+    {
+        for ( unsigned col = 0; col < _m; ++col )
+        {
+            double value = _B0[row * _m + col];
+            if ( value == 0.0 )
+                continue;
+
+            appendToBuffer<uint32_t>( payload, row );
+            appendToBuffer<uint32_t>( payload, col );
+            appendToBuffer<double>( payload, value );
+        }
+    }
+
+    if ( hasFactors )
+    {
+        // The LP sequence, in list order. Eta columns are stored sparsely.
+        appendToBuffer<uint32_t>( payload, _LP.size() );
+        for ( const auto &element : _LP )
+        {
+            if ( element->_pair )
+            {
+                appendToBuffer<uint32_t>( payload, LP_ELEMENT_PERMUTATION );
+                appendToBuffer<uint32_t>( payload, element->_pair->first );
+                appendToBuffer<uint32_t>( payload, element->_pair->second );
+            }
+            else
+            {
+                const EtaMatrix *eta = element->_eta;
+                appendToBuffer<uint32_t>( payload, LP_ELEMENT_ETA );
+                appendToBuffer<uint32_t>( payload, eta->_columnIndex );
+
+                uint32_t columnNnz = 0;
+                for ( unsigned i = 0; i < _m; ++i )
+                    if ( eta->_column[i] != 0.0 )
+                        ++columnNnz;
+
+                appendToBuffer<uint32_t>( payload, columnNnz );
+                for ( unsigned i = 0; i < _m; ++i )
+                {
+                    if ( eta->_column[i] == 0.0 )
+                        continue;
+
+                    appendToBuffer<uint32_t>( payload, i );
+                    appendToBuffer<double>( payload, eta->_column[i] );
+                }
+            }
+        }
+
+        // The strictly upper triangular part of U; its diagonal is all ones
+        uint64_t uNnz = 0;
+        for ( unsigned row = 0; row < _m; ++row )
+            for ( unsigned col = row + 1; col < _m; ++col )
+                if ( _U[getUIndex( row, col )] != 0.0 )
+                    ++uNnz;
+
+        appendToBuffer<uint64_t>( payload, uNnz );
+        for ( unsigned row = 0; row < _m; ++row )
+        {
+            for ( unsigned col = row + 1; col < _m; ++col )
+            {
+                double value = _U[getUIndex( row, col )];
+                if ( value == 0.0 )
+                    continue;
+
+                appendToBuffer<uint32_t>( payload, row );
+                appendToBuffer<uint32_t>( payload, col );
+                appendToBuffer<double>( payload, value );
+            }
+        }
+    }
+
+    FactorizationFileHeader header;
+    header._magic = FACTORIZATION_MAGIC;
+    header._version = FACTORIZATION_VERSION;
+    header._m = _m;
+    header._hasFactors = hasFactors;
+    header._payloadSize = payload.size();
+    header._checksum = HashUtils::hash( payload.data(), payload.size() );
+
+    // Write to a temporary file and rename it, so that a crash while
+    // saving never leaves a truncated file behind
+    String temporaryPath = path + ".tmp";
+
+    FILE *file = fopen( temporaryPath.ascii(), "wb" );
+    if ( !file )
+        throw CommonError( CommonError::OPEN_FAILED, temporaryPath.ascii() );
+
+    bool written =
+        ( fwrite( &header, sizeof(header), 1, file ) == 1 ) &&
+        ( fwrite( payload.data(), 1, payload.size(), file ) == payload.size() );
+    written = ( fclose( file ) == 0 ) && written;
+
+    if ( !written || rename( temporaryPath.ascii(), path.ascii() ) != 0 )
+    {
+        remove( temporaryPath.ascii() );
+        throw CommonError( CommonError::WRITE_FAILED, path.ascii() );
+    }
+}
+
+void BasisFactorization::loadFromFile( const String &path, unsigned *basicVariables )
+{
+    FILE *file = fopen( path.ascii(), "rb" );
+    if ( !file )
+        throw CommonError( CommonError::OPEN_FAILED, path.ascii() );
+
+    FactorizationFileHeader header;
+    std::vector<char> payload;
+
+    bool valid =
+        ( fread( &header, sizeof(header), 1, file ) == 1 ) &&
+        ( header._magic == FACTORIZATION_MAGIC ) &&
+        ( header._version == FACTORIZATION_VERSION ) &&
+        ( header._m == _m );
+
+    // The payload must fill the rest of the file; this also keeps a
+    // corrupt size from driving a huge allocation
+    if ( valid )
+    {
+        long payloadStart = ftell( file );
+        long fileEnd = ( ( payloadStart >= 0 ) && ( fseek( file, 0, SEEK_END ) == 0 ) ) ? ftell( file ) : -1;
+        valid =
+            ( fileEnd >= payloadStart ) && ( payloadStart >= 0 ) &&
+            ( (uint64_t)( fileEnd - payloadStart ) == header._payloadSize ) &&
+            ( fseek( file, payloadStart, SEEK_SET ) == 0 );
+    }
+
+    if ( valid )
+    {
+        payload.resize( header._payloadSize );
+        valid =
+            ( fread( payload.data(), 1, payload.size(), file ) == payload.size() ) &&
+            ( fgetc( file ) == EOF ) &&
+            ( HashUtils::hash( payload.data(), payload.size() ) == header._checksum );
+    }
+
+    fclose( file );
+
+    if ( !valid )
+        throw CommonError( CommonError::READ_FAILED, "BasisFactorization: invalid factorization file" );
+
+    // Parse everything into temporary storage first, so that a corrupt
+    // file leaves the current factorization untouched
+    PayloadReader reader( payload );
+
+    unsigned *newBasicVariables = new unsigned[_m];
+    double *newB0 = new double[_m * _m];
+    double *newU = header._hasFactors ? new double[getUSize()] : NULL;
+    List<LPElement *> newLP;
+
+    for ( unsigned i = 0; valid && i < _m; ++i )
+    {
+        uint32_t variable;
+        valid = reader.read( variable );
+        newBasicVariables[i] = variable;
+    }
+
+    std::fill_n( newB0, _m * _m, 0.0 );
+    uint64_t nnz = 0;
+    valid = valid && reader.read( nnz );
+    for ( uint64_t i = 0; valid && i < nnz; ++i )
+    {
+        uint32_t row, col;
+        double value;
+        valid = reader.read( row ) && reader.read( col ) && reader.read( value ) &&
+            ( row < _m ) && ( col < _m );
+
+        if ( valid )
+            newB0[row * _m + col] = value;
+    }
+
+    if ( header._hasFactors )
+    {
+        uint32_t numElements = 0;
+        valid = valid && reader.read( numElements );
+        for ( uint32_t i = 0; valid && i < numElements; ++i )
+        {
+            uint32_t kind, first, second;
+            valid = reader.read( kind ) && reader.read( first ) && ( first < _m );
+            if ( !valid )
+                break;
+
+            if ( kind == LP_ELEMENT_PERMUTATION )
+            {
+                valid = reader.read( second ) && ( second < _m );
+                if ( valid )
+                    newLP.append( _pool.allocatePermutationElement( first, second ) );
+            }
+            else if ( kind == LP_ELEMENT_ETA )
+            {
+                uint32_t columnNnz;
+                valid = reader.read( columnNnz );
+
+                std::fill_n( _LCol, _m, 0.0 );
+                for ( uint32_t j = 0; valid && j < columnNnz; ++j )
+                {
+                    uint32_t index;
+                    double value;
+                    valid = reader.read( index ) && reader.read( value ) && ( index < _m );
+                    if ( valid )
+                        _LCol[index] = value;
+                }
+
+                if ( valid )
+                    newLP.append( _pool.allocateEtaElement( first, _LCol ) );
+            }
+            else
+            {
+                valid = false;
+            }
+        }
+
+        std::fill_n( newU, getUSize(), 0.0 );
+
+        uint64_t uNnz = 0;
+        valid = valid && reader.read( uNnz );
+        for ( uint64_t i = 0; valid && i < uNnz; ++i )
+        {
+            uint32_t row, col;
+            double value;
+            valid = reader.read( row ) && reader.read( col ) && reader.read( value ) &&
+                ( row < col ) && ( col < _m );
+
+            if ( valid )
+                newU[getUIndex( row, col )] = value;
+        }
+    }
+
+    valid = valid && reader.atEnd();
+
+    if ( valid && !header._hasFactors )
+    {
+        // Factorize the new B0 while the current factors are set
+        // aside, so that a singular B0 leaves them in place
+        List<LPElement *> oldLP = _LP;
+        double *oldU = _U;
+        _LP.clear();
+        _U = NULL;
+
+        try
+        {
+            factorizeMatrix( newB0 );
+        }
+        catch ( ... )
+        {
+            clearLPU();
+            if ( _U )
+                delete[] _U;
+            _U = oldU;
+            _LP = oldLP;
+
+            delete[] newBasicVariables;
+            delete[] newB0;
+            throw;
+        }
+
+        for ( const auto &element : oldLP )
+            _pool.releaseElement( element );
+        if ( oldU )
+            delete[] oldU;
+    }
+
+    if ( valid )
+    {
+        // Install the new factorization
+        for ( const auto &it : _etas )
+            _pool.releaseEta( it );
+        _etas.clear();
+        if ( header._hasFactors )
+            clearLPU();
+        else
+            _rowCache.invalidate();
+
+        releaseBasisView();
+        _B0IsIdentity = false;
+        allocateB0();
+        memcpy( _B0, newB0, sizeof(double) * _m * _m );
+        memcpy( basicVariables, newBasicVariables, sizeof(unsigned) * _m );
+
+        if ( header._hasFactors )
+        {
+            if ( !_U )
+                _U = new double[getUSize()];
+            memcpy( _U, newU, sizeof(double) * getUSize() );
+            _LP = newLP;
+            newLP.clear();
+        }
+    }
+
+    for ( const auto &element : newLP )
+        _pool.releaseElement( element );
+
+    delete[] newBasicVariables;
+    delete[] newB0;
+    if ( newU )
+        delete[] newU;
+
+    if ( !valid )
+        throw CommonError( CommonError::READ_FAILED, "BasisFactorization: invalid factorization file" );
 }
 
 void BasisFactorization::invertB0( double *result )
+{
+    invertB0( result, NULL, _m );
+}
+
+void BasisFactorization::invertB0( double *result, const unsigned *columns, unsigned numColumns, ThreadPool *pool )
 {
     if ( !_etas.empty() )
         throw ReluplexError( ReluplexError::CANT_INVERT_BASIS_BECAUSE_OF_ETAS );
 
     ASSERT( result );
 
-    // Initialize the result to the identity matrix
-    for ( unsigned i = 0; i < _m; ++i )
-        for ( unsigned j = 0; j < _m; ++j )
-            result[i * _m + j] = ( i == j ) ? 1.0 : 0.0;
+    if ( !columns )
+        numColumns = _m;
 
     if ( _LP.empty() )
     {
         DEBUG({
                 // Assert B0 is the identity matrix.
-                for ( unsigned i = 0; i < _m; ++i )
+                for ( unsigned i = 0; !_B0IsIdentity && !_constraintMatrix && i < _m; ++i )
                     for ( unsigned j = 0; j < _m; ++j )
                         ASSERT( _B0[i * _m + j] == ( i == j ) ? 1.0 : 0.0 );
             });
 
+        for ( unsigned i = 0; i < _m; ++i )
+            for ( unsigned k = 0; k < numColumns; ++k )
+                result[i * numColumns + k] = ( i == ( columns ? columns[k] : k ) ) ? 1.0 : 0.0;
+
         return;
     }
 
-    // Apply the LP operations to the result
-    for ( List<LPElement *>::const_reverse_iterator it = _LP.rbegin(); it != _LP.rend(); ++it )
+    // Column k of the result is obtained by solving B0 * x = e_j, for
+    // the k'th requested column j. The columns are solved in panels;
+    // the panels are independent, and can be spread over the threads.
+    unsigned numPanels = ( numColumns + INVERSE_PANEL_WIDTH - 1 ) / INVERSE_PANEL_WIDTH;
+
+    if ( !pool || pool->getNumberOfThreads() == 1 || numPanels == 1 || _m < PARALLEL_INVERSE_MIN_DIMENSION )
     {
-        const LPElement *element = *it;
+        for ( unsigned panel = 0; panel < numPanels; ++panel )
+            invertB0Panel( columns, panel * INVERSE_PANEL_WIDTH, numColumns, result );
+        return;
+    }
+
+    for ( unsigned panel = 0; panel < numPanels; ++panel )
+        pool->submit( [this, columns, panel, numColumns, result]()
+                      {
+                          invertB0Panel( columns, panel * INVERSE_PANEL_WIDTH, numColumns, result );
+                      } );
+    pool->waitForAll();
+}
 
-        if ( element->_pair )
+void BasisFactorization::invertB0Panel( const unsigned *columns,
+                                        unsigned first,
+                                        unsigned numColumns,
+                                        double *result ) const
+{
+    unsigned width = std::min<unsigned>( INVERSE_PANEL_WIDTH, numColumns - first );
+
+    // The panel's right hand sides, one after the other, and the
+    // highest row at which each one is nonzero
+    double *panel = new double[_m * width];
+    if ( !panel )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BasisFactorization::panel" );
+
+    unsigned lastNonZero[INVERSE_PANEL_WIDTH];
+
+    std::fill_n( panel, _m * width, 0.0 );
+    for ( unsigned k = 0; k < width; ++k )
+    {
+        unsigned column = columns ? columns[first + k] : first + k;
+        ASSERT( column < _m );
+        panel[k * _m + column] = 1.0;
+        lastNonZero[k] = column;
+    }
+
+    // Multiply by P1,L1,...,Pm,Lm on the left, as in the forward
+    // transformation. An eta matrix only changes a vector whose entry
+    // at its column is nonzero, which, for the unit vectors, skips
+    // most of them.
+    for ( auto element = _LP.rbegin(); element != _LP.rend(); ++element )
+    {
+        if ( (*element)->_pair )
         {
-            rowSwap( element->_pair->first, element->_pair->second, result );
+            unsigned rowOne = (*element)->_pair->first;
+            unsigned rowTwo = (*element)->_pair->second;
+
+            for ( unsigned k = 0; k < width; ++k )
+            {
+                double *x = panel + k * _m;
+                double temp = x[rowOne];
+                x[rowOne] = x[rowTwo];
+                x[rowTwo] = temp;
+
+                if ( x[rowOne] != 0.0 || x[rowTwo] != 0.0 )
+                    lastNonZero[k] = std::max( lastNonZero[k], std::max( rowOne, rowTwo ) );
+            }
         }
         else
         {
-            unsigned colIndex = element->_eta->_columnIndex;
+            const EtaMatrix *L = (*element)->_eta;
+            unsigned col = L->_columnIndex;
+
+            // The eta is lower triangular, so its entries are below col
+            unsigned lastInColumn = _m - 1;
+            while ( lastInColumn > col && L->_column[lastInColumn] == 0.0 )
+                --lastInColumn;
 
-            // First, perform in-place multiplication for all rows below the pivot row
-            for ( unsigned row = colIndex + 1; row < _m; ++row )
+            for ( unsigned k = 0; k < width; ++k )
             {
-                for ( unsigned col = 0; col < _m; ++col )
-                    result[row * _m + col] += element->_eta->_column[row] * result[colIndex * _m + col];
-            }
+                double *x = panel + k * _m;
+                double xCol = x[col];
+                if ( xCol == 0.0 )
+                    continue;
+
+                for ( unsigned i = col + 1; i <= lastInColumn; ++i )
+                    x[i] += xCol * L->_column[i];
+                x[col] *= L->_column[col];
 
-            // Finally, perform the multiplication for the pivot row
-            // itself. We change this row last because it is required for all
-            // previous multiplication operations.
-            for ( unsigned i = 0; i < _m; ++i )
-                result[colIndex * _m + i] *= element->_eta->_column[colIndex];
+                lastNonZero[k] = std::max( lastNonZero[k], lastInColumn );
+            }
         }
     }
 
-    // Apply the U operations to the result
-    for ( int col = _m - 1; col > 0; --col )
+    // Solve U * x = y for every vector of the panel. Entries below the
+    // last nonzero of y stay zero.
+    for ( unsigned k = 0; k < width; ++k )
     {
-        for ( int row = col - 1; row >= 0; --row )
+        double *x = panel + k * _m;
+        unsigned last = lastNonZero[k];
+
+        for ( int i = (int)last - 1; i >= 0; --i )
         {
-            double uElement = _U[row * _m + col];
-            if ( FloatUtils::isZero( uElement ) )
-                continue;
+            const double *uRow = _U + getUIndex( i, i + 1 );
 
-            for ( unsigned k = 0; k < _m; ++k )
-                result[row * _m + k] += -uElement * result[col * _m + k];
+            double sum = 0;
+            for ( unsigned j = i + 1; j <= last; ++j )
+                sum += uRow[j - i - 1] * x[j];
+            x[i] -= sum;
         }
+
+        for ( unsigned i = 0; i < _m; ++i )
+            result[i * numColumns + first + k] = x[i];
     }
+
+    delete[] panel;
 }
 
 void BasisFactorization::log( const String &message )
@@ -14,16 +14,59 @@
 #ifndef __BasisFactorization_h__
 #define __BasisFactorization_h__
 
+#include "FactorPool.h"
+#include "InverseRowCache.h"
 #include "LPElement.h"
 #include "List.h"
 #include "MString.h"
 
 class EtaMatrix;
 class LPElement;
+class SparseColumnMatrix;
+class ThreadPool;
 
 class BasisFactorization
 {
 public:
+    enum {
+        // The number of columns of the inverse solved together
+        INVERSE_PANEL_WIDTH = 16,
+
+        // Below this dimension, inverting on a thread pool costs more
+        // than it saves
+        PARALLEL_INVERSE_MIN_DIMENSION = 128,
+    };
+
+    /*
+      A source of the columns of an m x m matrix, e.g. of the basic
+      columns of the constraint matrix. getColumn() writes the nonzero
+      entries of a column as distinct row indices and their values,
+      into arrays of size m, and returns their number.
+    */
+    class ColumnOracle
+    {
+    public:
+        virtual ~ColumnOracle() {}
+        virtual unsigned getColumn( unsigned column, unsigned *rowIndices, double *values ) const = 0;
+    };
+
+    /*
+      A matrix in compressed sparse column form: the entries of column
+      j are at positions columnStart[j] up to columnStart[j + 1] of
+      rowIndices and values. The arrays are not copied.
+    */
+    class CompressedColumns : public ColumnOracle
+    {
+    public:
+        CompressedColumns( const unsigned *columnStart, const unsigned *rowIndices, const double *values );
+        unsigned getColumn( unsigned column, unsigned *rowIndices, double *values ) const;
+
+    private:
+        const unsigned *_columnStart;
+        const unsigned *_rowIndices;
+        const double *_values;
+    };
+
     BasisFactorization( unsigned m );
     ~BasisFactorization();
 
@@ -40,6 +83,14 @@ public:
     */
     void pushEtaMatrix( unsigned columnIndex, double *column );
 
+    /*
+      The same, for a basis view (see setBasis()): the column of the
+      constraint matrix that enters the basis at position columnIndex
+      is given, so that the view can follow the basis. Without a basis
+      view, the entering column is ignored.
+    */
+    void pushEtaMatrix( unsigned columnIndex, double *column, unsigned enteringColumn );
+
     /*
       Perform a forward transformation, i.e. find x such that x = inv(B) * y,
       The solution is found by solving Bx = y.
@@ -82,6 +133,22 @@ public:
     */
     void backwardTransformation( const double *y, double *x ) const;
 
+    /*
+      Compute row i of inv(B), i.e. the backward transformation of the
+      i'th unit vector. Recently requested rows are cached, and kept up
+      to date as etas are pushed, until the basis is refactorized.
+
+      Result needs to be of size m.
+    */
+    void getInverseRow( unsigned row, double *result );
+
+    /*
+      The cache of rows of inv(B), for its statistics. Setting its
+      capacity to 0 disables it.
+    */
+    const InverseRowCache &getInverseRowCache() const;
+    void setInverseRowCacheCapacity( unsigned capacity );
+
     /*
       Store and restore the basis factorization. Storing triggers
       condesning the etas.
@@ -89,17 +156,66 @@ public:
     void storeFactorization( BasisFactorization *other );
     void restoreFactorization( const BasisFactorization *other );
 
+    /*
+      Save the factorization to a binary file, so that a later run can
+      start from it. The file holds the identities of the m basic
+      columns (provided by the caller), B0 in sparse form and,
+      optionally, the LU factors of B0. As with storing, the etas are
+      condensed first. The file is replaced atomically.
+
+      Loading restores B0 and fills in the basic column identities. If
+      the file holds the LU factors they are installed as they are;
+      otherwise B0 is factorized before anything is replaced. Corrupt
+      or mismatched files cause a CommonError, and a singular B0 a
+      ReluplexError; either way the factorization is left unchanged.
+    */
+    void saveToFile( const String &path, const unsigned *basicVariables, bool includeFactors = true );
+    void loadFromFile( const String &path, unsigned *basicVariables );
+
 	/*
       Factorize a matrix into LU form. The resuling upper triangular
       matrix is stored in _U and the lower triangular and permutation matrices
-      are stored in _LP.
+      are stored in _LP. The matrix itself is not changed.
 	*/
     void factorizeMatrix( double *matrix );
 
+    /*
+      Factorize a matrix given by its columns, in compressed sparse
+      column form or through an oracle, without a dense copy of it
+      being made first. The columns are scattered straight into the
+      elimination workspace, which the dense LU needs anyway.
+    */
+    void factorizeMatrix( const unsigned *columnStart, const unsigned *rowIndices, const double *values );
+    void factorizeMatrix( const ColumnOracle &oracle );
+
 	/*
-      Set B0 to a non-identity matrix and factorize it.
+      Set B0 to a non-identity matrix and factorize it. The columns are
+      not kept by reference, so B0 is stored densely, as condensing the
+      etas needs it; setBasis() keeps B0 in sparse form instead.
 	*/
 	void setB0( const double *B0 );
+    void setB0( const unsigned *columnStart, const unsigned *rowIndices, const double *values );
+    void setB0( const ColumnOracle &oracle );
+
+    /*
+      Set B0 to the given columns of a constraint matrix, which must
+      outlive the factorization (and any factorization this one is
+      stored into), and factorize it. B0 is then represented by its m
+      basic column indices only, both here and when stored, and is
+      refactorized by reading the columns from the matrix instead of
+      condensing the etas into a dense copy.
+
+      The view is kept for as long as etas are pushed together with
+      their entering columns; pushing an eta without one, or setting B0
+      explicitly, turns B0 back into a dense matrix.
+    */
+    void setBasis( const SparseColumnMatrix *matrix, const unsigned *basicColumns );
+
+    /*
+      The current basic columns of a basis view (reflecting the pushed
+      etas), or NULL if B0 is not a basis view.
+    */
+    const unsigned *getBasicColumns() const;
 
 	/*
       Swap two rows of a matrix.
@@ -107,12 +223,31 @@ public:
     void rowSwap( unsigned rowOne, unsigned rowTwo, double *matrix );
 
     /*
-      Getter functions for the various factorization components.
+      Getter functions for the various factorization components. B0 is
+      allocated on demand if it is still the implicit identity; U is
+      NULL until B0 has been factorized.
+
+      U has a unit diagonal, and only its strictly upper triangular part
+      is stored, packed by rows: row i holds columns i+1 to m-1, at
+      getUIndex( i, i + 1 ) onwards. It has getUSize() entries.
     */
 	const double *getU() const;
-	const List<LPElement *> getLP() const;
+    unsigned getUSize() const;
+
+    unsigned getUIndex( unsigned row, unsigned column ) const
+    {
+        return row * _m - row * ( row + 1 ) / 2 + column - row - 1;
+    }
+
+	const List<LPElement *> &getLP() const;
 	const double *getB0() const;
-	const List<EtaMatrix *> getEtas() const;
+	const List<EtaMatrix *> &getEtas() const;
+
+    /*
+      Check whether B0 is the identity matrix, which is represented
+      without storing it.
+    */
+    bool isB0Identity() const;
 
     /*
       Check/set whether factorization is enabled.
@@ -120,6 +255,13 @@ public:
     bool factorizationEnabled() const;
     void toggleFactorization( bool value );
 
+    /*
+      The number of stored etas above which the basis is condensed and
+      refactorized. Defaults to the global configuration.
+    */
+    unsigned getRefactorizationThreshold() const;
+    void setRefactorizationThreshold( unsigned threshold );
+
     /*
       Compute B0 * E1 ... *En for all stored eta matrices, and place
       the result in B0.
@@ -132,6 +274,17 @@ public:
      */
     void invertB0( double *result );
 
+    /*
+      Compute only some columns of the inverse of B0: column k of the
+      result, an m x numColumns row-major matrix, is column columns[k]
+      of inv(B0). If columns is NULL, all m columns are computed. The
+      columns are solved as blocks of right hand sides. If a thread
+      pool is given, which must not be running other tasks, and the
+      basis is large enough, the blocks are distributed over it;
+      otherwise they are solved on the calling thread.
+    */
+    void invertB0( double *result, const unsigned *columns, unsigned numColumns, ThreadPool *pool = NULL );
+
     /*
       A helper function for matrix multiplication.
       left * right = result.
@@ -140,9 +293,15 @@ public:
 
 private:
     /*
-      The Basis matrix.
+      The Basis matrix. Until B0 is first set or condensed it is the
+      identity, which is only flagged; the dense array is allocated
+      when it is needed, and then holds the identity while the flag is
+      set. Materializing it does not change the factorization, so it
+      is allowed on const objects. While B0 is a basis view, the dense
+      array is only a scratch copy for getB0().
     */
-	double *_B0;
+	mutable double *_B0;
+    bool _B0IsIdentity;
 
     /*
       The dimension of the basis matrix.
@@ -150,9 +309,10 @@ private:
     unsigned _m;
 
     /*
-      The LU factorization on B0. U is upper triangular, and LP is a
-      sequence of lower triangular eta matrices and permuatation
-      pairs.
+      The LU factorization on B0, which is empty while B0 is the
+      implicit identity. U is unit upper triangular, packed (see
+      getU()), and is allocated on the first factorization. LP is a sequence of lower triangular eta
+      matrices and permuatation pairs.
     */
 	double *_U;
 	List<LPElement *> _LP;
@@ -162,23 +322,95 @@ private:
     */
     List<EtaMatrix *> _etas;
 
+    /*
+      Recycles the etas and LP elements, so that the simplex iterations
+      and refactorizations do not allocate.
+    */
+    FactorPool _pool;
+
+    /*
+      Rows of inv(B) recently requested by getInverseRow().
+    */
+    InverseRowCache _rowCache;
+
     /*
       A flag that controls whether LU-factorization is enabled or
       disabled.
     */
     bool _factorizationEnabled;
 
+    /*
+      The number of etas that triggers refactorization.
+    */
+    unsigned _refactorizationThreshold;
+
+    /*
+      The basis view, if any: the constraint matrix, the basic columns
+      that make up B0, and the basic columns after the etas.
+    */
+    const SparseColumnMatrix *_constraintMatrix;
+    unsigned *_basicColumns;
+    unsigned *_currentBasicColumns;
+
     /*
       Working space
     */
     double *_tempY;
     double *_LCol;
+    double *_leavingRow;
+    unsigned *_rowIndices;
+
+    /*
+      The m x m elimination workspace of factorizeMatrix
+    */
+    double *_workspace;
 
     /*
       Clear a previous factorization.
     */
 	void clearLPU();
 
+    /*
+      Allocate the dense B0 if it does not exist yet. A new array holds
+      the identity while the identity flag is set, and is otherwise
+      left for the caller to fill. Writing to it must clear the
+      identity flag.
+    */
+    void allocateB0() const;
+
+    /*
+      Stop using the basis view, if any, before B0 is replaced. The
+      basic column arrays are kept for reuse, but no longer describe B0.
+    */
+    void releaseBasisView();
+
+    /*
+      Drop all etas and the LU factors, and set B0 to the identity.
+    */
+    void resetToIdentity();
+
+    /*
+      Replace a basis view by a dense B0 holding the same matrix.
+    */
+    void materializeBasisView();
+
+    /*
+      Factorize B0, which is either dense or a basis view.
+    */
+    void factorizeB0();
+
+    /*
+      Store an eta matrix, and refactorize if there are too many.
+    */
+    void appendEta( unsigned columnIndex, double *column );
+
+    /*
+      Solve for up to INVERSE_PANEL_WIDTH columns of the inverse of B0,
+      starting at the first'th requested column. Only reads the
+      factorization, so panels can be solved concurrently.
+    */
+    void invertB0Panel( const unsigned *columns, unsigned first, unsigned numColumns, double *result ) const;
+
     /*
       Helper functions for backward- and forward-transformations.
       Compute L*X or X*L, where X is vector of length m and L is an (m x m)
@@ -187,11 +419,21 @@ private:
 	void LMultiplyLeft( const EtaMatrix *L, double *X ) const;
     void LMultiplyRight( const EtaMatrix *L, double *X ) const;
 
+    /*
+      The elimination needs the whole matrix, so it is performed in the
+      dense workspace, which is allocated on the first factorization
+      and reused by later ones. Only the strictly upper triangular part
+      of the result is kept in U.
+    */
+    void allocateWorkspace();
+    void scatterColumns( const ColumnOracle &oracle, double *matrix ) const;
+    void factorizeWorkspace();
+
 	/*
-      Multiply matrix U on the left by lower triangular eta matrix L,
-      store result in U.
+      Multiply a dense matrix on the left by lower triangular eta
+      matrix L, in place. Used on the workspace of factorizeMatrix.
     */
-	void LFactorizationMultiply( const EtaMatrix *L );
+	void LFactorizationMultiply( const EtaMatrix *L, double *matrix ) const;
 
     static void log( const String &message );
 };
@@ -0,0 +1,227 @@
+/*********************                                                        */
+/*! \file BatchPreprocessor.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "BatchPreprocessor.h"
+#include "BoundPropagator.h"
+#include "Debug.h"
+#include "InfeasibleQueryException.h"
+#include "ReluplexError.h"
+#include "ThreadPool.h"
+
+#include <cstring>
+
+BatchPreprocessor::BatchPreprocessor( const InputQuery &network )
+    : _network( network )
+    , _n( network.getNumberOfVariables() )
+    , _networkLowerBounds( NULL )
+    , _networkUpperBounds( NULL )
+{
+    _networkLowerBounds = new double[_n];
+    if ( !_networkLowerBounds )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BatchPreprocessor::networkLowerBounds" );
+
+    _networkUpperBounds = new double[_n];
+    if ( !_networkUpperBounds )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BatchPreprocessor::networkUpperBounds" );
+
+    for ( unsigned i = 0; i < _n; ++i )
+    {
+        _networkLowerBounds[i] = _network.getLowerBound( i );
+        _networkUpperBounds[i] = _network.getUpperBound( i );
+    }
+}
+
+BatchPreprocessor::~BatchPreprocessor()
+{
+    freeIfNeeded();
+}
+
+void BatchPreprocessor::freeIfNeeded()
+{
+    if ( _networkLowerBounds )
+    {
+        delete[] _networkLowerBounds;
+        _networkLowerBounds = NULL;
+    }
+
+    if ( _networkUpperBounds )
+    {
+        delete[] _networkUpperBounds;
+        _networkUpperBounds = NULL;
+    }
+
+    for ( unsigned i = 0; i < _queries.size(); ++i )
+    {
+        if ( _queries[i]->_lowerBounds )
+            delete[] _queries[i]->_lowerBounds;
+
+        if ( _queries[i]->_upperBounds )
+            delete[] _queries[i]->_upperBounds;
+
+        delete _queries[i];
+    }
+
+    _queries.clear();
+}
+
+unsigned BatchPreprocessor::addQuery( const Map<unsigned, double> &lowerBounds,
+                                      const Map<unsigned, double> &upperBounds )
+{
+    for ( const auto &bound : lowerBounds )
+    {
+        if ( bound.first >= _n )
+            throw ReluplexError( ReluplexError::VARIABLE_INDEX_OUT_OF_RANGE, "BatchPreprocessor::addQuery" );
+    }
+
+    for ( const auto &bound : upperBounds )
+    {
+        if ( bound.first >= _n )
+            throw ReluplexError( ReluplexError::VARIABLE_INDEX_OUT_OF_RANGE, "BatchPreprocessor::addQuery" );
+    }
+
+    QueryEntry *entry = new QueryEntry;
+    entry->_lowerBoundOverrides = lowerBounds;
+    entry->_upperBoundOverrides = upperBounds;
+    entry->_processed = false;
+    entry->_infeasible = false;
+    entry->_numTighteningIterations = 0;
+    entry->_lowerBounds = NULL;
+    entry->_upperBounds = NULL;
+
+    _queries.append( entry );
+    return _queries.size() - 1;
+}
+
+unsigned BatchPreprocessor::getNumberOfQueries() const
+{
+    return _queries.size();
+}
+
+void BatchPreprocessor::preprocess( unsigned numberOfThreads )
+{
+    ThreadPool pool( numberOfThreads );
+
+    for ( unsigned i = 0; i < _queries.size(); ++i )
+    {
+        QueryEntry *entry = _queries[i];
+        if ( entry->_processed )
+            continue;
+
+        pool.submit( [this, entry]() { processQuery( entry ); } );
+    }
+
+    pool.waitForAll();
+}
+
+void BatchPreprocessor::processQuery( QueryEntry *entry ) const
+{
+    // Overlay the property's bounds on top of the network's bounds. A
+    // previous attempt that threw may have left the arrays allocated.
+    if ( !entry->_lowerBounds )
+        entry->_lowerBounds = new double[_n];
+    if ( !entry->_upperBounds )
+        entry->_upperBounds = new double[_n];
+
+    entry->_infeasible = false;
+    entry->_numTighteningIterations = 0;
+
+    memcpy( entry->_lowerBounds, _networkLowerBounds, sizeof(double) * _n );
+    memcpy( entry->_upperBounds, _networkUpperBounds, sizeof(double) * _n );
+
+    for ( const auto &bound : entry->_lowerBoundOverrides )
+        entry->_lowerBounds[bound.first] = bound.second;
+    for ( const auto &bound : entry->_upperBoundOverrides )
+        entry->_upperBounds[bound.first] = bound.second;
+
+    BoundPropagator propagator( _n, entry->_lowerBounds, entry->_upperBounds );
+    const List<Equation> &equations( _network.getEquations() );
+
+    // The constraints are notified of the bounds, so this task needs
+    // its own copies of them. The equations are only read.
+    List<PiecewiseLinearConstraint *> constraints;
+
+    try
+    {
+        for ( const auto &constraint : _network.getPiecewiseLinearConstraints() )
+            constraints.append( constraint->duplicateConstraint() );
+
+        bool continueTightening = true;
+        while ( continueTightening )
+        {
+            continueTightening = propagator.processEquations( equations );
+            continueTightening = propagator.processConstraints( constraints ) || continueTightening;
+
+            ++entry->_numTighteningIterations;
+        }
+    }
+    catch ( const InfeasibleQueryException & )
+    {
+        entry->_infeasible = true;
+    }
+    catch ( ... )
+    {
+        for ( const auto &constraint : constraints )
+            delete constraint;
+        throw;
+    }
+
+    memcpy( entry->_lowerBounds, propagator.getLowerBounds(), sizeof(double) * _n );
+    memcpy( entry->_upperBounds, propagator.getUpperBounds(), sizeof(double) * _n );
+
+    for ( const auto &constraint : constraints )
+        delete constraint;
+
+    entry->_processed = true;
+}
+
+bool BatchPreprocessor::queryIsInfeasible( unsigned id ) const
+{
+    ASSERT( _queries[id]->_processed );
+    return _queries[id]->_infeasible;
+}
+
+unsigned BatchPreprocessor::getNumTighteningIterations( unsigned id ) const
+{
+    ASSERT( _queries[id]->_processed );
+    return _queries[id]->_numTighteningIterations;
+}
+
+const double *BatchPreprocessor::getLowerBounds( unsigned id ) const
+{
+    ASSERT( _queries[id]->_processed );
+    return _queries[id]->_lowerBounds;
+}
+
+const double *BatchPreprocessor::getUpperBounds( unsigned id ) const
+{
+    ASSERT( _queries[id]->_processed );
+    return _queries[id]->_upperBounds;
+}
+
+InputQuery BatchPreprocessor::materialize( unsigned id ) const
+{
+    ASSERT( _queries[id]->_processed );
+
+    InputQuery query = _network;
+    BoundPropagator bounds( _n, _queries[id]->_lowerBounds, _queries[id]->_upperBounds );
+    bounds.storeBounds( query );
+
+    return query;
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
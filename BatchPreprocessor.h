@@ -0,0 +1,120 @@
+/*********************                                                        */
+/*! \file BatchPreprocessor.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __BatchPreprocessor_h__
+#define __BatchPreprocessor_h__
+
+#include "InputQuery.h"
+#include "Map.h"
+#include "Vector.h"
+
+/*
+  Preprocesses many property queries over the same network. The
+  network (equations, piecewise linear constraints and default bounds)
+  is kept in a single shared query that is never modified; each
+  property is described only by the bounds in which it differs from
+  the network. Bound tightening for the properties runs on a thread
+  pool, and each result is a pair of dense bound vectors.
+
+  Piecewise linear constraints carry per-query state, so each running
+  task works on its own duplicates of the constraints and releases
+  them when done. Peak memory is thus one network plus one set of
+  constraints per thread, plus two bound vectors per property.
+
+  Variable elimination changes the structure of the network and is
+  not performed here; use materialize() and a regular Preprocessor
+  for the properties that require it.
+*/
+class BatchPreprocessor
+{
+public:
+    /*
+      The network must outlive the batch preprocessor.
+    */
+    BatchPreprocessor( const InputQuery &network );
+    ~BatchPreprocessor();
+
+    /*
+      Free any allocated memory.
+    */
+    void freeIfNeeded();
+
+    /*
+      Add a property, given as overrides of the network's bounds.
+      Returns the property's id. Throws if an override refers to a
+      variable that the network does not have.
+    */
+    unsigned addQuery( const Map<unsigned, double> &lowerBounds,
+                       const Map<unsigned, double> &upperBounds );
+
+    unsigned getNumberOfQueries() const;
+
+    /*
+      Tighten the bounds of all the added properties, using the given
+      number of threads (0 means one thread per hardware thread).
+      Properties that were already processed are skipped. An error
+      while processing a property, other than its infeasibility, is
+      rethrown here once all the properties are done.
+    */
+    void preprocess( unsigned numberOfThreads = 0 );
+
+    /*
+      Obtain the results for a processed property.
+    */
+    bool queryIsInfeasible( unsigned id ) const;
+    unsigned getNumTighteningIterations( unsigned id ) const;
+    const double *getLowerBounds( unsigned id ) const;
+    const double *getUpperBounds( unsigned id ) const;
+
+    /*
+      Create a stand-alone input query for a processed property: a copy
+      of the network with the property's tightened bounds.
+    */
+    InputQuery materialize( unsigned id ) const;
+
+private:
+    struct QueryEntry
+    {
+        Map<unsigned, double> _lowerBoundOverrides;
+        Map<unsigned, double> _upperBoundOverrides;
+
+        bool _processed;
+        bool _infeasible;
+        unsigned _numTighteningIterations;
+
+        double *_lowerBounds;
+        double *_upperBounds;
+    };
+
+    const InputQuery &_network;
+
+    /*
+      The network's own bounds, in dense form.
+    */
+    unsigned _n;
+    double *_networkLowerBounds;
+    double *_networkUpperBounds;
+
+    Vector<QueryEntry *> _queries;
+
+    void processQuery( QueryEntry *entry ) const;
+};
+
+#endif // __BatchPreprocessor_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,320 @@
+/*********************                                                        */
+/*! \file BoundPropagator.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "BoundPropagator.h"
+#include "Debug.h"
+#include "FloatUtils.h"
+#include "GlobalConfiguration.h"
+#include "InfeasibleQueryException.h"
+#include "InputQuery.h"
+#include "PerfCounters.h"
+#include "Probes.h"
+#include "ReluplexError.h"
+#include "Tightening.h"
+#include "TraceRecorder.h"
+
+BoundPropagator::BoundPropagator( const InputQuery &query )
+    : _store( NULL )
+    , _ownsStore( true )
+    , _numTightenings( 0 )
+{
+    _store = new BoundStore( query );
+    if ( !_store )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BoundPropagator::store" );
+}
+
+BoundPropagator::BoundPropagator( unsigned n, const double *lowerBounds, const double *upperBounds )
+    : _store( NULL )
+    , _ownsStore( true )
+    , _numTightenings( 0 )
+{
+    _store = new BoundStore( n );
+    if ( !_store )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BoundPropagator::store" );
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        _store->setLowerBound( i, lowerBounds[i] );
+        _store->setUpperBound( i, upperBounds[i] );
+    }
+}
+
+BoundPropagator::BoundPropagator( BoundStore &store )
+    : _store( &store )
+    , _ownsStore( false )
+    , _numTightenings( 0 )
+{
+}
+
+BoundPropagator::~BoundPropagator()
+{
+    freeIfNeeded();
+}
+
+void BoundPropagator::freeIfNeeded()
+{
+    if ( _store && _ownsStore )
+        delete _store;
+
+    _store = NULL;
+}
+
+bool BoundPropagator::processEquations( const List<Equation> &equations )
+{
+    PERF_COUNTER_SCOPE( PerfCounters::PROCESS_EQUATIONS );
+    TRACE_SCOPE( "process-equations", "propagation" );
+
+    bool tighterBoundFound = false;
+    const double *lowerBounds = _store->getLowerBounds();
+    const double *upperBounds = _store->getUpperBounds();
+
+    for ( const auto &equation : equations )
+    {
+        for ( const auto &varBeingTightened : equation._addends )
+        {
+            // The equation is of the form a * varBeingTightened + sum (bi * xi) = c,
+            // or: a * varBeingTightened = c - sum (bi * xi)
+
+            // We first compute the lower and upper bounds for the expression c - sum (bi * xi)
+            double scalarUB = equation._scalar;
+            double scalarLB = equation._scalar;
+            bool validLB = true;
+            bool validUB = true;
+
+            for ( const auto &addend : equation._addends )
+            {
+                if ( varBeingTightened._variable == addend._variable )
+                    continue;
+
+                if ( FloatUtils::isNegative( addend._coefficient ) )
+                {
+                    if ( validLB )
+                    {
+                        double addendLB = lowerBounds[addend._variable];
+                        if ( FloatUtils::isFinite( addendLB ) )
+                            scalarLB -= addend._coefficient * addendLB;
+                        else
+                            validLB = false;
+                    }
+
+                    if ( validUB )
+                    {
+                        double addendUB = upperBounds[addend._variable];
+                        if ( FloatUtils::isFinite( addendUB ) )
+                            scalarUB -= addend._coefficient * addendUB;
+                        else
+                            validUB = false;
+                    }
+                }
+
+                if ( FloatUtils::isPositive( addend._coefficient ) )
+                {
+                    if ( validLB )
+                    {
+                        double addendUB = upperBounds[addend._variable];
+                        if ( FloatUtils::isFinite( addendUB ) )
+                            scalarLB -= addend._coefficient * addendUB;
+                        else
+                            validLB = false;
+                    }
+
+                    if ( validUB )
+                    {
+                        double addendLB = lowerBounds[addend._variable];
+                        if ( FloatUtils::isFinite( addendLB ) )
+                            scalarUB -= addend._coefficient * addendLB;
+                        else
+                            validUB = false;
+                    }
+                }
+            }
+
+            // We know that lb < a * varBeingTightened < ub. We want to divide by a, but we care about the sign
+            // If a is positive: lb/a < x < ub/a
+            // If a is negative: lb/a > x > ub/a
+            if ( validLB )
+                scalarLB = scalarLB / varBeingTightened._coefficient;
+            if ( validUB )
+                scalarUB = scalarUB / varBeingTightened._coefficient;
+
+            if ( FloatUtils::isNegative( varBeingTightened._coefficient ) )
+            {
+                double temp = scalarUB;
+                scalarUB = scalarLB;
+                scalarLB = temp;
+
+                bool tempValid = validUB;
+                validUB = validLB;
+                validLB = tempValid;
+            }
+
+            unsigned variable = varBeingTightened._variable;
+
+            if ( validLB && FloatUtils::gt( scalarLB, lowerBounds[variable],
+                                            GlobalConfiguration::BOUND_COMPARISON_TOLERANCE ) )
+            {
+                tighterBoundFound = true;
+                _store->setLowerBound( variable, scalarLB );
+                MARABOU_PROBE3( bound__tighten, variable, 0, Probes::bits( scalarLB ) );
+                ++_numTightenings;
+            }
+
+            if ( validUB && FloatUtils::lt( scalarUB, upperBounds[variable],
+                                            GlobalConfiguration::BOUND_COMPARISON_TOLERANCE ) )
+            {
+                tighterBoundFound = true;
+                _store->setUpperBound( variable, scalarUB );
+                MARABOU_PROBE3( bound__tighten, variable, 1, Probes::bits( scalarUB ) );
+                ++_numTightenings;
+            }
+
+            if ( FloatUtils::gt( lowerBounds[variable], upperBounds[variable],
+                                 GlobalConfiguration::BOUND_COMPARISON_TOLERANCE ) )
+            {
+                throw InfeasibleQueryException();
+            }
+        }
+    }
+
+    return tighterBoundFound;
+}
+
+bool BoundPropagator::processConstraints( const List<PiecewiseLinearConstraint *> &constraints )
+{
+    TRACE_SCOPE( "process-constraints", "propagation" );
+
+    bool tighterBoundFound = false;
+    const double *lowerBounds = _store->getLowerBounds();
+    const double *upperBounds = _store->getUpperBounds();
+
+    indexConstraints( constraints );
+
+    List<Tightening> tightenings;
+    unsigned index = 0;
+    for ( const auto &constraint : constraints )
+    {
+        for ( unsigned i = _constraintStart[index]; i < _constraintStart[index + 1]; ++i )
+        {
+            unsigned variable = _constraintVariables[i];
+            constraint->notifyLowerBound( variable, lowerBounds[variable] );
+            constraint->notifyUpperBound( variable, upperBounds[variable] );
+        }
+        ++index;
+
+        tightenings.clear();
+        constraint->getEntailedTightenings( tightenings );
+
+        for ( const auto &tightening : tightenings )
+        {
+            if ( ( tightening._type == Tightening::LB ) &&
+                 FloatUtils::gt( tightening._value, lowerBounds[tightening._variable] ) )
+            {
+                tighterBoundFound = true;
+                _store->setLowerBound( tightening._variable, tightening._value );
+                MARABOU_PROBE3( bound__tighten, tightening._variable, 0, Probes::bits( tightening._value ) );
+                ++_numTightenings;
+            }
+
+            else if ( ( tightening._type == Tightening::UB ) &&
+                      FloatUtils::lt( tightening._value, upperBounds[tightening._variable] ) )
+            {
+                tighterBoundFound = true;
+                _store->setUpperBound( tightening._variable, tightening._value );
+                MARABOU_PROBE3( bound__tighten, tightening._variable, 1, Probes::bits( tightening._value ) );
+                ++_numTightenings;
+            }
+        }
+    }
+
+    return tighterBoundFound;
+}
+
+void BoundPropagator::indexConstraints( const List<PiecewiseLinearConstraint *> &constraints )
+{
+    if ( _indexedConstraints.size() == constraints.size() )
+    {
+        bool same = true;
+        unsigned index = 0;
+        for ( const auto &constraint : constraints )
+        {
+            if ( _indexedConstraints[index++] != constraint )
+            {
+                same = false;
+                break;
+            }
+        }
+
+        if ( same )
+            return;
+    }
+
+    _indexedConstraints.clear();
+    _constraintStart.clear();
+    _constraintVariables.clear();
+
+    for ( const auto &constraint : constraints )
+    {
+        _indexedConstraints.append( constraint );
+        _constraintStart.append( _constraintVariables.size() );
+        for ( unsigned variable : constraint->getParticipatingVariables() )
+            _constraintVariables.append( variable );
+    }
+    _constraintStart.append( _constraintVariables.size() );
+}
+
+unsigned BoundPropagator::getNumberOfVariables() const
+{
+    return _store->getNumberOfVariables();
+}
+
+double BoundPropagator::getLowerBound( unsigned variable ) const
+{
+    return _store->getLowerBound( variable );
+}
+
+double BoundPropagator::getUpperBound( unsigned variable ) const
+{
+    return _store->getUpperBound( variable );
+}
+
+unsigned BoundPropagator::getNumTightenings() const
+{
+    return _numTightenings;
+}
+
+const double *BoundPropagator::getLowerBounds() const
+{
+    return _store->getLowerBounds();
+}
+
+const double *BoundPropagator::getUpperBounds() const
+{
+    return _store->getUpperBounds();
+}
+
+BoundStore &BoundPropagator::getBoundStore()
+{
+    return *_store;
+}
+
+void BoundPropagator::storeBounds( InputQuery &query ) const
+{
+    _store->storeBounds( query );
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
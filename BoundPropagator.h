@@ -0,0 +1,122 @@
+/*********************                                                        */
+/*! \file BoundPropagator.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __BoundPropagator_h__
+#define __BoundPropagator_h__
+
+#include "BoundStore.h"
+#include "Equation.h"
+#include "List.h"
+#include "PiecewiseLinearConstraint.h"
+#include "Vector.h"
+
+class InputQuery;
+
+/*
+  Tightens variable bounds using linear equations and piecewise
+  linear constraints. The bounds are kept in a BoundStore, either owned
+  by the propagator or shared with the search, so that the equations
+  and constraints themselves can be shared (read-only) between several
+  propagators.
+*/
+class BoundPropagator
+{
+public:
+    /*
+      Initialize the bounds from an input query, or from explicit
+      arrays of size n.
+    */
+    BoundPropagator( const InputQuery &query );
+    BoundPropagator( unsigned n, const double *lowerBounds, const double *upperBounds );
+
+    /*
+      Work directly on an existing bound store. Tightenings made above
+      level 0 are recorded on its trail.
+    */
+    BoundPropagator( BoundStore &store );
+    ~BoundPropagator();
+
+    /*
+      Free any allocated memory.
+    */
+    void freeIfNeeded();
+
+    /*
+      Tighten bounds using the linear equations. Returns true if a
+      tighter bound was found, and throws an InfeasibleQueryException
+      if a variable's lower bound exceeds its upper bound.
+    */
+    bool processEquations( const List<Equation> &equations );
+
+    /*
+      Tighten bounds using the piecewise linear constraints. The
+      constraints are notified of the current bounds. Returns true if a
+      tighter bound was found.
+
+      The participating variables of the constraints are fetched once,
+      and reused for as long as the same constraints are processed, so
+      they must not change in the meantime.
+    */
+    bool processConstraints( const List<PiecewiseLinearConstraint *> &constraints );
+
+    /*
+      Access the current bounds.
+    */
+    unsigned getNumberOfVariables() const;
+    double getLowerBound( unsigned variable ) const;
+    double getUpperBound( unsigned variable ) const;
+    const double *getLowerBounds() const;
+    const double *getUpperBounds() const;
+    BoundStore &getBoundStore();
+
+    /*
+      The number of bounds tightened so far.
+    */
+    unsigned getNumTightenings() const;
+
+    /*
+      Write any bounds that differ from the query's bounds back into
+      the query.
+    */
+    void storeBounds( InputQuery &query ) const;
+
+private:
+    BoundStore *_store;
+    bool _ownsStore;
+
+    unsigned _numTightenings;
+
+    /*
+      The constraints last processed and their participating variables:
+      those of the i'th constraint are at positions _constraintStart[i]
+      up to _constraintStart[i + 1] of _constraintVariables.
+    */
+    Vector<PiecewiseLinearConstraint *> _indexedConstraints;
+    Vector<unsigned> _constraintStart;
+    Vector<unsigned> _constraintVariables;
+
+    /*
+      Fetch the participating variables, unless the constraints are the
+      ones already indexed.
+    */
+    void indexConstraints( const List<PiecewiseLinearConstraint *> &constraints );
+};
+
+#endif // __BoundPropagator_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,192 @@
+/*********************                                                        */
+/*! \file BoundStore.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "BoundStore.h"
+#include "Debug.h"
+#include "FloatUtils.h"
+#include "InputQuery.h"
+#include "ReluplexError.h"
+
+BoundStore::BoundStore( unsigned n )
+    : _n( n )
+    , _lowerBounds( NULL )
+    , _upperBounds( NULL )
+{
+    allocate();
+
+    for ( unsigned i = 0; i < _n; ++i )
+    {
+        _lowerBounds[i] = FloatUtils::negativeInfinity();
+        _upperBounds[i] = FloatUtils::infinity();
+    }
+}
+
+BoundStore::BoundStore( const InputQuery &query )
+    : _n( query.getNumberOfVariables() )
+    , _lowerBounds( NULL )
+    , _upperBounds( NULL )
+{
+    allocate();
+
+    for ( unsigned i = 0; i < _n; ++i )
+    {
+        _lowerBounds[i] = query.getLowerBound( i );
+        _upperBounds[i] = query.getUpperBound( i );
+    }
+}
+
+BoundStore::~BoundStore()
+{
+    freeIfNeeded();
+}
+
+void BoundStore::allocate()
+{
+    _lowerBounds = new double[_n];
+    if ( !_lowerBounds )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BoundStore::lowerBounds" );
+
+    _upperBounds = new double[_n];
+    if ( !_upperBounds )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "BoundStore::upperBounds" );
+}
+
+void BoundStore::freeIfNeeded()
+{
+    if ( _lowerBounds )
+    {
+        delete[] _lowerBounds;
+        _lowerBounds = NULL;
+    }
+
+    if ( _upperBounds )
+    {
+        delete[] _upperBounds;
+        _upperBounds = NULL;
+    }
+}
+
+unsigned BoundStore::getNumberOfVariables() const
+{
+    return _n;
+}
+
+double BoundStore::getLowerBound( unsigned variable ) const
+{
+    ASSERT( variable < _n );
+    return _lowerBounds[variable];
+}
+
+double BoundStore::getUpperBound( unsigned variable ) const
+{
+    ASSERT( variable < _n );
+    return _upperBounds[variable];
+}
+
+const double *BoundStore::getLowerBounds() const
+{
+    return _lowerBounds;
+}
+
+const double *BoundStore::getUpperBounds() const
+{
+    return _upperBounds;
+}
+
+void BoundStore::record( unsigned variable, bool upper, double oldValue )
+{
+    if ( _levelStart.empty() )
+        return;
+
+    TrailEntry entry;
+    entry._variable = variable;
+    entry._upper = upper;
+    entry._oldValue = oldValue;
+    _trail.append( entry );
+}
+
+void BoundStore::setLowerBound( unsigned variable, double value )
+{
+    ASSERT( variable < _n );
+    record( variable, false, _lowerBounds[variable] );
+    _lowerBounds[variable] = value;
+}
+
+void BoundStore::setUpperBound( unsigned variable, double value )
+{
+    ASSERT( variable < _n );
+    record( variable, true, _upperBounds[variable] );
+    _upperBounds[variable] = value;
+}
+
+void BoundStore::pushLevel()
+{
+    _levelStart.append( _trail.size() );
+}
+
+void BoundStore::popLevel( UndoListener *listener )
+{
+    ASSERT( !_levelStart.empty() );
+
+    unsigned start = _levelStart.last();
+    _levelStart.popBack();
+
+    while ( _trail.size() > start )
+    {
+        const TrailEntry &entry = _trail.last();
+        double *bounds = entry._upper ? _upperBounds : _lowerBounds;
+
+        if ( listener )
+            listener->boundRestored( entry._variable, entry._upper, bounds[entry._variable], entry._oldValue );
+
+        bounds[entry._variable] = entry._oldValue;
+        _trail.popBack();
+    }
+}
+
+void BoundStore::popToLevel( unsigned level, UndoListener *listener )
+{
+    while ( getLevel() > level )
+        popLevel( listener );
+}
+
+unsigned BoundStore::getLevel() const
+{
+    return _levelStart.size();
+}
+
+unsigned BoundStore::getTrailSize() const
+{
+    return _trail.size();
+}
+
+void BoundStore::storeBounds( InputQuery &query ) const
+{
+    ASSERT( query.getNumberOfVariables() == _n );
+
+    for ( unsigned i = 0; i < _n; ++i )
+    {
+        if ( _lowerBounds[i] != query.getLowerBound( i ) )
+            query.setLowerBound( i, _lowerBounds[i] );
+
+        if ( _upperBounds[i] != query.getUpperBound( i ) )
+            query.setUpperBound( i, _upperBounds[i] );
+    }
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
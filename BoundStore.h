@@ -0,0 +1,119 @@
+/*********************                                                        */
+/*! \file BoundStore.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __BoundStore_h__
+#define __BoundStore_h__
+
+#include "Vector.h"
+
+#include <cstddef>
+
+class InputQuery;
+
+/*
+  Variable bounds in dense lower and upper arrays, with an undo trail.
+
+  A checkpoint opens a new decision level, which only records the
+  current length of the trail. Every bound change made above level 0
+  appends the old value to the trail, and backtracking undoes the
+  changes made since the checkpoint, so it costs time proportional to
+  the number of changed bounds rather than to the number of variables.
+  Changes made at level 0 are permanent and are not recorded.
+*/
+class BoundStore
+{
+public:
+    /*
+      Notified of every bound restored while backtracking, before the
+      new value is written, e.g. to keep derived data in sync.
+    */
+    class UndoListener
+    {
+    public:
+        virtual ~UndoListener() {}
+        virtual void boundRestored( unsigned variable, bool upper, double currentValue, double restoredValue ) = 0;
+    };
+
+    /*
+      Create a store with unbounded variables, or with the bounds of a
+      query.
+    */
+    BoundStore( unsigned n );
+    BoundStore( const InputQuery &query );
+    ~BoundStore();
+
+    /*
+      Free any allocated memory.
+    */
+    void freeIfNeeded();
+
+    unsigned getNumberOfVariables() const;
+
+    double getLowerBound( unsigned variable ) const;
+    double getUpperBound( unsigned variable ) const;
+    const double *getLowerBounds() const;
+    const double *getUpperBounds() const;
+
+    /*
+      Set a bound, recording the old value if above level 0.
+    */
+    void setLowerBound( unsigned variable, double value );
+    void setUpperBound( unsigned variable, double value );
+
+    /*
+      Open a new decision level in O(1), or undo all changes since the
+      start of the current level.
+    */
+    void pushLevel();
+    void popLevel( UndoListener *listener = NULL );
+    void popToLevel( unsigned level, UndoListener *listener = NULL );
+    unsigned getLevel() const;
+
+    /*
+      The number of recorded changes, over all levels.
+    */
+    unsigned getTrailSize() const;
+
+    /*
+      Write any bounds that differ from the query's bounds back into
+      the query.
+    */
+    void storeBounds( InputQuery &query ) const;
+
+private:
+    struct TrailEntry
+    {
+        unsigned _variable;
+        bool _upper;
+        double _oldValue;
+    };
+
+    unsigned _n;
+    double *_lowerBounds;
+    double *_upperBounds;
+
+    Vector<TrailEntry> _trail;
+    Vector<unsigned> _levelStart;
+
+    void allocate();
+    void record( unsigned variable, bool upper, double oldValue );
+};
+
+#endif // __BoundStore_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
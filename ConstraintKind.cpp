@@ -0,0 +1,39 @@
+/*********************                                                        */
+/*! \file ConstraintKind.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "ConstraintKind.h"
+#include "MaxConstraint.h"
+#include "ReluConstraint.h"
+
+ConstraintKind::Kind ConstraintKind::of( const PiecewiseLinearConstraint *constraint )
+{
+    if ( dynamic_cast<const ReluConstraint *>( constraint ) )
+        return RELU;
+
+    if ( dynamic_cast<const MaxConstraint *>( constraint ) )
+        return MAX;
+
+    return UNKNOWN;
+}
+
+bool ConstraintKind::isValid( uint64_t kind )
+{
+    return ( kind == RELU ) || ( kind == MAX );
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,60 @@
+/*********************                                                        */
+/*! \file ConstraintKind.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __ConstraintKind_h__
+#define __ConstraintKind_h__
+
+#include <stdint.h>
+
+class PiecewiseLinearConstraint;
+
+/*
+  Stable identifiers of the kinds of piecewise linear constraints, for
+  use in on-disk formats and content hashes. Unlike type names, they
+  do not depend on the compiler or the build. The values of existing
+  kinds never change; new kinds get new values, and VERSION is bumped
+  whenever the set of kinds changes.
+*/
+class ConstraintKind
+{
+public:
+    enum Kind {
+        UNKNOWN = 0,
+        RELU = 1,
+        MAX = 2,
+    };
+
+    enum {
+        VERSION = 1,
+    };
+
+    /*
+      The kind of a constraint, or UNKNOWN if it has none of the kinds
+      above.
+    */
+    static Kind of( const PiecewiseLinearConstraint *constraint );
+
+    /*
+      Check whether a stored value is a known kind.
+    */
+    static bool isValid( uint64_t kind );
+};
+
+#endif // __ConstraintKind_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,129 @@
+/*********************                                                        */
+/*! \file FactorPool.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "Debug.h"
+#include "EtaMatrix.h"
+#include "FactorPool.h"
+#include "LPElement.h"
+
+#include <cstring>
+#include <utility>
+
+FactorPool::FactorPool( unsigned m )
+    : _m( m )
+    , _numAllocations( 0 )
+    , _numReuses( 0 )
+{
+}
+
+FactorPool::~FactorPool()
+{
+    clear();
+}
+
+EtaMatrix *FactorPool::allocateEta( unsigned columnIndex, const double *column )
+{
+    if ( _freeEtas.empty() )
+    {
+        ++_numAllocations;
+        return new EtaMatrix( _m, columnIndex, column );
+    }
+
+    ++_numReuses;
+
+    EtaMatrix *eta = _freeEtas.last();
+    _freeEtas.popBack();
+
+    eta->_columnIndex = columnIndex;
+    memcpy( eta->_column, column, sizeof(double) * _m );
+    return eta;
+}
+
+LPElement *FactorPool::allocateEtaElement( unsigned columnIndex, const double *column )
+{
+    if ( _freeEtaElements.empty() )
+        return new LPElement( allocateEta( columnIndex, column ), NULL );
+
+    ++_numReuses;
+
+    LPElement *element = _freeEtaElements.last();
+    _freeEtaElements.popBack();
+
+    element->_eta->_columnIndex = columnIndex;
+    memcpy( element->_eta->_column, column, sizeof(double) * _m );
+    return element;
+}
+
+LPElement *FactorPool::allocatePermutationElement( unsigned first, unsigned second )
+{
+    if ( _freePermutationElements.empty() )
+    {
+        ++_numAllocations;
+        return new LPElement( NULL, new std::pair<unsigned, unsigned>( first, second ) );
+    }
+
+    ++_numReuses;
+
+    LPElement *element = _freePermutationElements.last();
+    _freePermutationElements.popBack();
+
+    element->_pair->first = first;
+    element->_pair->second = second;
+    return element;
+}
+
+void FactorPool::releaseEta( EtaMatrix *eta )
+{
+    ASSERT( eta->_m == _m );
+    _freeEtas.append( eta );
+}
+
+void FactorPool::releaseElement( LPElement *element )
+{
+    if ( element->_pair )
+        _freePermutationElements.append( element );
+    else
+        _freeEtaElements.append( element );
+}
+
+void FactorPool::clear()
+{
+    for ( unsigned i = 0; i < _freeEtas.size(); ++i )
+        delete _freeEtas[i];
+    _freeEtas.clear();
+
+    for ( unsigned i = 0; i < _freeEtaElements.size(); ++i )
+        delete _freeEtaElements[i];
+    _freeEtaElements.clear();
+
+    for ( unsigned i = 0; i < _freePermutationElements.size(); ++i )
+        delete _freePermutationElements[i];
+    _freePermutationElements.clear();
+}
+
+unsigned long long FactorPool::getNumAllocations() const
+{
+    return _numAllocations;
+}
+
+unsigned long long FactorPool::getNumReuses() const
+{
+    return _numReuses;
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
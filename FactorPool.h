@@ -0,0 +1,83 @@
+/*********************                                                        */
+/*! \file FactorPool.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __FactorPool_h__
+#define __FactorPool_h__
+
+#include "Vector.h"
+
+class EtaMatrix;
+class LPElement;
+
+/*
+  Recycles the eta matrices and LP elements of a basis factorization
+  of dimension m. Released objects are kept on free lists, together
+  with their m-length columns, and handed out again instead of
+  allocating new ones, so that once the pool has grown to the largest
+  factorization seen, pushing etas and refactorizing allocate nothing.
+*/
+class FactorPool
+{
+public:
+    FactorPool( unsigned m );
+    ~FactorPool();
+
+    /*
+      An eta matrix with the given column. The column is copied.
+    */
+    EtaMatrix *allocateEta( unsigned columnIndex, const double *column );
+
+    /*
+      LP elements: a lower triangular eta matrix, or a swap of two rows.
+    */
+    LPElement *allocateEtaElement( unsigned columnIndex, const double *column );
+    LPElement *allocatePermutationElement( unsigned first, unsigned second );
+
+    /*
+      Return objects to the pool. Releasing an eta element also releases
+      its eta matrix.
+    */
+    void releaseEta( EtaMatrix *eta );
+    void releaseElement( LPElement *element );
+
+    /*
+      Free all pooled objects.
+    */
+    void clear();
+
+    /*
+      The number of objects allocated, and the number of requests served
+      from the free lists.
+    */
+    unsigned long long getNumAllocations() const;
+    unsigned long long getNumReuses() const;
+
+private:
+    unsigned _m;
+
+    Vector<EtaMatrix *> _freeEtas;
+    Vector<LPElement *> _freeEtaElements;
+    Vector<LPElement *> _freePermutationElements;
+
+    unsigned long long _numAllocations;
+    unsigned long long _numReuses;
+};
+
+#endif // __FactorPool_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,67 @@
+/*********************                                                        */
+/*! \file HashUtils.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __HashUtils_h__
+#define __HashUtils_h__
+
+#include <cstring>
+#include <stdint.h>
+
+/*
+  FNV-1a hashing, used for content keys and checksums of on-disk
+  data. The result depends only on the bytes hashed, so it is stable
+  across runs and processes.
+*/
+class HashUtils
+{
+public:
+    static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+    static uint64_t hash( const void *data, uint64_t size, uint64_t seed = FNV_OFFSET_BASIS )
+    {
+        const unsigned char *bytes = (const unsigned char *)data;
+        uint64_t result = seed;
+        for ( uint64_t i = 0; i < size; ++i )
+        {
+            result ^= bytes[i];
+            result *= FNV_PRIME;
+        }
+        return result;
+    }
+
+    static uint64_t hashUnsigned( unsigned value, uint64_t seed )
+    {
+        return hash( &value, sizeof(value), seed );
+    }
+
+    static uint64_t hashDouble( double value, uint64_t seed )
+    {
+        // Positive and negative zero should hash alike
+        if ( value == 0.0 )
+            value = 0.0;
+
+        uint64_t bits;
+        memcpy( &bits, &value, sizeof(bits) );
+        return hash( &bits, sizeof(bits), seed );
+    }
+};
+
+#endif // __HashUtils_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
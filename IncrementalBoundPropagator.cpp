@@ -0,0 +1,495 @@
+/*********************                                                        */
+/*! \file IncrementalBoundPropagator.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "Debug.h"
+#include "FloatUtils.h"
+#include "GlobalConfiguration.h"
+#include "IncrementalBoundPropagator.h"
+#include "InputQuery.h"
+#include "Probes.h"
+#include "ReluplexError.h"
+#include "Tightening.h"
+
+IncrementalBoundPropagator::IncrementalBoundPropagator( const InputQuery &query )
+    : _n( query.getNumberOfVariables() )
+    , _numEquations( 0 )
+    , _store( NULL )
+    , _ownsStore( true )
+    , _inConflict( false )
+    , _numTightenings( 0 )
+    , _numEquationVisits( 0 )
+    , _numBacktrackedChanges( 0 )
+{
+    _store = new BoundStore( query );
+    if ( !_store )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "IncrementalBoundPropagator::store" );
+
+    initialize( query );
+}
+
+IncrementalBoundPropagator::IncrementalBoundPropagator( const InputQuery &query, BoundStore &store )
+    : _n( query.getNumberOfVariables() )
+    , _numEquations( 0 )
+    , _store( &store )
+    , _ownsStore( false )
+    , _inConflict( false )
+    , _numTightenings( 0 )
+    , _numEquationVisits( 0 )
+    , _numBacktrackedChanges( 0 )
+{
+    ASSERT( store.getNumberOfVariables() == _n );
+    initialize( query );
+}
+
+IncrementalBoundPropagator::~IncrementalBoundPropagator()
+{
+    if ( _store && _ownsStore )
+        delete _store;
+
+    _store = NULL;
+}
+
+void IncrementalBoundPropagator::initialize( const InputQuery &query )
+{
+    // Store the equations in compressed sparse row form, and count the
+    // occurrences of each variable
+    Vector<unsigned> occurrenceCount;
+    for ( unsigned i = 0; i < _n; ++i )
+        occurrenceCount.append( 0 );
+
+    for ( const auto &equation : query.getEquations() )
+    {
+        _equationStart.append( _equationVariables.size() );
+        for ( const auto &addend : equation._addends )
+        {
+            // An addend with a zero coefficient neither contributes to
+            // the activities nor can be tightened through
+            if ( FloatUtils::isZero( addend._coefficient ) )
+                continue;
+
+            _equationVariables.append( addend._variable );
+            _equationCoefficients.append( addend._coefficient );
+            ++occurrenceCount[addend._variable];
+        }
+
+        _scalars.append( equation._scalar );
+        ++_numEquations;
+    }
+    _equationStart.append( _equationVariables.size() );
+
+    // Transpose into per-variable occurrence lists
+    _occurrenceStart.append( 0 );
+    for ( unsigned i = 0; i < _n; ++i )
+        _occurrenceStart.append( _occurrenceStart[i] + occurrenceCount[i] );
+
+    for ( unsigned i = 0; i < _equationVariables.size(); ++i )
+    {
+        _occurrenceEquations.append( 0 );
+        _occurrenceCoefficients.append( 0.0 );
+    }
+
+    Vector<unsigned> position;
+    for ( unsigned i = 0; i < _n; ++i )
+        position.append( _occurrenceStart[i] );
+
+    for ( unsigned equation = 0; equation < _numEquations; ++equation )
+    {
+        for ( unsigned j = _equationStart[equation]; j < _equationStart[equation + 1]; ++j )
+        {
+            unsigned slot = position[_equationVariables[j]]++;
+            _occurrenceEquations[slot] = equation;
+            _occurrenceCoefficients[slot] = _equationCoefficients[j];
+        }
+    }
+
+    // The same for the pl constraints. The participating variables are
+    // fetched once, here.
+    Vector<unsigned> constraintCount;
+    for ( unsigned i = 0; i < _n; ++i )
+        constraintCount.append( 0 );
+
+    for ( const auto &constraint : query.getPiecewiseLinearConstraints() )
+    {
+        _constraintStart.append( _constraintVariables.size() );
+        for ( unsigned variable : constraint->getParticipatingVariables() )
+        {
+            _constraintVariables.append( variable );
+            ++constraintCount[variable];
+        }
+
+        _constraints.append( constraint );
+    }
+    _constraintStart.append( _constraintVariables.size() );
+
+    _variableConstraintStart.append( 0 );
+    for ( unsigned i = 0; i < _n; ++i )
+    {
+        _variableConstraintStart.append( _variableConstraintStart[i] + constraintCount[i] );
+        position[i] = _variableConstraintStart[i];
+    }
+
+    for ( unsigned i = 0; i < _constraintVariables.size(); ++i )
+        _variableConstraints.append( 0 );
+
+    for ( unsigned constraint = 0; constraint < _constraints.size(); ++constraint )
+        for ( unsigned j = _constraintStart[constraint]; j < _constraintStart[constraint + 1]; ++j )
+            _variableConstraints[position[_constraintVariables[j]]++] = constraint;
+
+    // Everything needs to be visited once
+    for ( unsigned equation = 0; equation < _numEquations; ++equation )
+    {
+        _dirtyEquations.append( equation );
+        _equationIsDirty.append( true );
+        _minActivity.append( 0.0 );
+        _maxActivity.append( 0.0 );
+        _minInfinite.append( 0 );
+        _maxInfinite.append( 0 );
+    }
+
+    for ( unsigned constraint = 0; constraint < _constraints.size(); ++constraint )
+    {
+        _dirtyConstraints.append( constraint );
+        _constraintIsDirty.append( true );
+    }
+
+    recomputeActivities();
+}
+
+void IncrementalBoundPropagator::recomputeActivities()
+{
+    const double *lowerBounds = _store->getLowerBounds();
+    const double *upperBounds = _store->getUpperBounds();
+
+    for ( unsigned equation = 0; equation < _numEquations; ++equation )
+    {
+        _minActivity[equation] = 0.0;
+        _maxActivity[equation] = 0.0;
+        _minInfinite[equation] = 0;
+        _maxInfinite[equation] = 0;
+
+        for ( unsigned j = _equationStart[equation]; j < _equationStart[equation + 1]; ++j )
+        {
+            unsigned variable = _equationVariables[j];
+            double coefficient = _equationCoefficients[j];
+            bool positive = FloatUtils::isPositive( coefficient );
+
+            double minBound = positive ? lowerBounds[variable] : upperBounds[variable];
+            double maxBound = positive ? upperBounds[variable] : lowerBounds[variable];
+
+            if ( FloatUtils::isFinite( minBound ) )
+                _minActivity[equation] += coefficient * minBound;
+            else
+                ++_minInfinite[equation];
+
+            if ( FloatUtils::isFinite( maxBound ) )
+                _maxActivity[equation] += coefficient * maxBound;
+            else
+                ++_maxInfinite[equation];
+        }
+    }
+}
+
+void IncrementalBoundPropagator::pushLevel()
+{
+    _store->pushLevel();
+
+    PendingWork pending;
+    pending._dirtyEquations = _dirtyEquations;
+    pending._dirtyConstraints = _dirtyConstraints;
+    pending._inConflict = _inConflict;
+    _pendingAtLevel.append( pending );
+}
+
+void IncrementalBoundPropagator::popLevel()
+{
+    _store->popLevel( this );
+
+    for ( unsigned equation : _dirtyEquations )
+        _equationIsDirty[equation] = false;
+    _dirtyEquations.clear();
+
+    for ( unsigned constraint : _dirtyConstraints )
+        _constraintIsDirty[constraint] = false;
+    _dirtyConstraints.clear();
+
+    _inConflict = false;
+
+    // A level opened directly on a shared store is assumed to have
+    // started from propagated bounds
+    if ( _pendingAtLevel.empty() )
+        return;
+
+    // Whatever was waiting when the level was opened is waiting again
+    const PendingWork &pending( _pendingAtLevel.last() );
+
+    for ( unsigned equation : pending._dirtyEquations )
+    {
+        _equationIsDirty[equation] = true;
+        _dirtyEquations.append( equation );
+    }
+
+    for ( unsigned constraint : pending._dirtyConstraints )
+    {
+        _constraintIsDirty[constraint] = true;
+        _dirtyConstraints.append( constraint );
+    }
+
+    _inConflict = pending._inConflict;
+    _pendingAtLevel.popBack();
+}
+
+unsigned IncrementalBoundPropagator::getLevel() const
+{
+    return _store->getLevel();
+}
+
+void IncrementalBoundPropagator::boundRestored( unsigned variable, bool upper, double currentValue, double restoredValue )
+{
+    updateActivities( variable, upper, currentValue, restoredValue );
+    ++_numBacktrackedChanges;
+}
+
+bool IncrementalBoundPropagator::tightenLowerBound( unsigned variable, double value )
+{
+    ASSERT( variable < _n );
+
+    if ( !FloatUtils::gt( value, _store->getLowerBound( variable ) ) )
+        return false;
+
+    setBound( variable, false, value );
+    return true;
+}
+
+bool IncrementalBoundPropagator::tightenUpperBound( unsigned variable, double value )
+{
+    ASSERT( variable < _n );
+
+    if ( !FloatUtils::lt( value, _store->getUpperBound( variable ) ) )
+        return false;
+
+    setBound( variable, true, value );
+    return true;
+}
+
+void IncrementalBoundPropagator::setBound( unsigned variable, bool upper, double value )
+{
+    if ( upper )
+    {
+        updateActivities( variable, true, _store->getUpperBound( variable ), value );
+        _store->setUpperBound( variable, value );
+    }
+    else
+    {
+        updateActivities( variable, false, _store->getLowerBound( variable ), value );
+        _store->setLowerBound( variable, value );
+    }
+
+    ++_numTightenings;
+    MARABOU_PROBE3( bound__tighten, variable, upper ? 1 : 0, Probes::bits( value ) );
+
+    if ( FloatUtils::gt( _store->getLowerBound( variable ), _store->getUpperBound( variable ),
+                         GlobalConfiguration::BOUND_COMPARISON_TOLERANCE ) )
+        _inConflict = true;
+
+    markDirty( variable );
+}
+
+void IncrementalBoundPropagator::updateActivities( unsigned variable, bool upper, double oldValue, double newValue )
+{
+    bool oldFinite = FloatUtils::isFinite( oldValue );
+    bool newFinite = FloatUtils::isFinite( newValue );
+
+    for ( unsigned j = _occurrenceStart[variable]; j < _occurrenceStart[variable + 1]; ++j )
+    {
+        unsigned equation = _occurrenceEquations[j];
+        double coefficient = _occurrenceCoefficients[j];
+
+        // A lower bound contributes to the minimal activity if the
+        // coefficient is positive, and to the maximal one otherwise
+        bool affectsMin = FloatUtils::isPositive( coefficient ) != upper;
+        double &activity = affectsMin ? _minActivity[equation] : _maxActivity[equation];
+        unsigned &infinite = affectsMin ? _minInfinite[equation] : _maxInfinite[equation];
+
+        if ( oldFinite )
+            activity -= coefficient * oldValue;
+        else
+            --infinite;
+
+        if ( newFinite )
+            activity += coefficient * newValue;
+        else
+            ++infinite;
+    }
+}
+
+void IncrementalBoundPropagator::markDirty( unsigned variable )
+{
+    for ( unsigned j = _occurrenceStart[variable]; j < _occurrenceStart[variable + 1]; ++j )
+    {
+        unsigned equation = _occurrenceEquations[j];
+        if ( !_equationIsDirty[equation] )
+        {
+            _equationIsDirty[equation] = true;
+            _dirtyEquations.append( equation );
+        }
+    }
+
+    for ( unsigned j = _variableConstraintStart[variable]; j < _variableConstraintStart[variable + 1]; ++j )
+    {
+        unsigned constraint = _variableConstraints[j];
+        if ( !_constraintIsDirty[constraint] )
+        {
+            _constraintIsDirty[constraint] = true;
+            _dirtyConstraints.append( constraint );
+        }
+    }
+}
+
+bool IncrementalBoundPropagator::propagate()
+{
+    while ( !_inConflict && ( !_dirtyEquations.empty() || !_dirtyConstraints.empty() ) )
+    {
+        if ( !_dirtyEquations.empty() )
+        {
+            unsigned equation = _dirtyEquations.last();
+            _dirtyEquations.popBack();
+            _equationIsDirty[equation] = false;
+
+            propagateEquation( equation );
+        }
+        else
+        {
+            unsigned constraint = _dirtyConstraints.last();
+            _dirtyConstraints.popBack();
+            _constraintIsDirty[constraint] = false;
+
+            propagateConstraint( constraint );
+        }
+    }
+
+    return !_inConflict;
+}
+
+bool IncrementalBoundPropagator::propagateEquation( unsigned equation )
+{
+    ++_numEquationVisits;
+
+    const double *lowerBounds = _store->getLowerBounds();
+    const double *upperBounds = _store->getUpperBounds();
+    double scalar = _scalars[equation];
+
+    for ( unsigned j = _equationStart[equation]; j < _equationStart[equation + 1]; ++j )
+    {
+        unsigned variable = _equationVariables[j];
+        double coefficient = _equationCoefficients[j];
+        bool positive = FloatUtils::isPositive( coefficient );
+
+        // The contribution of this addend to the activities
+        double minBound = positive ? lowerBounds[variable] : upperBounds[variable];
+        double maxBound = positive ? upperBounds[variable] : lowerBounds[variable];
+        bool minFinite = FloatUtils::isFinite( minBound );
+        bool maxFinite = FloatUtils::isFinite( maxBound );
+
+        // The range of the other addends: sum( bi * xi ) for xi != variable
+        bool validMin = ( _minInfinite[equation] - ( minFinite ? 0 : 1 ) ) == 0;
+        bool validMax = ( _maxInfinite[equation] - ( maxFinite ? 0 : 1 ) ) == 0;
+        double othersMin = _minActivity[equation] - ( minFinite ? coefficient * minBound : 0.0 );
+        double othersMax = _maxActivity[equation] - ( maxFinite ? coefficient * maxBound : 0.0 );
+
+        // a * variable = c - others, so a * variable is in
+        // [c - othersMax, c - othersMin]. Dividing by a negative a
+        // flips the interval.
+        bool validLB = positive ? validMax : validMin;
+        bool validUB = positive ? validMin : validMax;
+        double newLB = ( scalar - ( positive ? othersMax : othersMin ) ) / coefficient;
+        double newUB = ( scalar - ( positive ? othersMin : othersMax ) ) / coefficient;
+
+        if ( validLB && FloatUtils::gt( newLB, lowerBounds[variable],
+                                        GlobalConfiguration::BOUND_COMPARISON_TOLERANCE ) )
+            setBound( variable, false, newLB );
+
+        if ( validUB && FloatUtils::lt( newUB, upperBounds[variable],
+                                        GlobalConfiguration::BOUND_COMPARISON_TOLERANCE ) )
+            setBound( variable, true, newUB );
+
+        if ( _inConflict )
+            return false;
+    }
+
+    return true;
+}
+
+bool IncrementalBoundPropagator::propagateConstraint( unsigned constraint )
+{
+    PiecewiseLinearConstraint *plConstraint = _constraints[constraint];
+
+    for ( unsigned j = _constraintStart[constraint]; j < _constraintStart[constraint + 1]; ++j )
+    {
+        unsigned variable = _constraintVariables[j];
+        plConstraint->notifyLowerBound( variable, _store->getLowerBound( variable ) );
+        plConstraint->notifyUpperBound( variable, _store->getUpperBound( variable ) );
+    }
+
+    List<Tightening> tightenings;
+    plConstraint->getEntailedTightenings( tightenings );
+
+    for ( const auto &tightening : tightenings )
+    {
+        if ( tightening._type == Tightening::LB )
+            tightenLowerBound( tightening._variable, tightening._value );
+        else
+            tightenUpperBound( tightening._variable, tightening._value );
+
+        if ( _inConflict )
+            return false;
+    }
+
+    return true;
+}
+
+double IncrementalBoundPropagator::getLowerBound( unsigned variable ) const
+{
+    return _store->getLowerBound( variable );
+}
+
+double IncrementalBoundPropagator::getUpperBound( unsigned variable ) const
+{
+    return _store->getUpperBound( variable );
+}
+
+BoundStore &IncrementalBoundPropagator::getBoundStore()
+{
+    return *_store;
+}
+
+unsigned long long IncrementalBoundPropagator::getNumTightenings() const
+{
+    return _numTightenings;
+}
+
+unsigned long long IncrementalBoundPropagator::getNumEquationVisits() const
+{
+    return _numEquationVisits;
+}
+
+unsigned long long IncrementalBoundPropagator::getNumBacktrackedChanges() const
+{
+    return _numBacktrackedChanges;
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
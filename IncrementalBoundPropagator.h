@@ -0,0 +1,198 @@
+/*********************                                                        */
+/*! \file IncrementalBoundPropagator.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __IncrementalBoundPropagator_h__
+#define __IncrementalBoundPropagator_h__
+
+#include "BoundStore.h"
+#include "List.h"
+#include "PiecewiseLinearConstraint.h"
+#include "Vector.h"
+
+class InputQuery;
+
+/*
+  Bound propagation for use during the search. It performs the same
+  reasoning as the preprocessor's propagation (each equation bounds
+  each of its variables by the bounds of the others, and the pl
+  constraints report entailed tightenings), but incrementally:
+
+    - For every equation it keeps the minimal and maximal activity,
+      i.e. the range of sum( a_i * x_i ) under the current bounds, and
+      updates them whenever a bound changes. Bounding one variable from
+      an equation is then O(1), so revisiting an equation is linear in
+      its length rather than quadratic.
+
+    - Only the equations and constraints that involve a variable whose
+      bound changed are revisited, starting from the split variable.
+
+    - The bounds live in a BoundStore, which records every change
+      above level 0 on its trail. Backtracking restores bounds and
+      activities in time proportional to the number of changes.
+
+  The pl constraints are notified of bound changes, but keep their own
+  internal state; restoring it on backtrack remains the search's
+  responsibility, as it is today.
+*/
+class IncrementalBoundPropagator : public BoundStore::UndoListener
+{
+public:
+    /*
+      Build the propagator for a (typically preprocessed) query. The
+      query's pl constraints must outlive the propagator.
+    */
+    IncrementalBoundPropagator( const InputQuery &query );
+
+    /*
+      Work on an existing bound store, e.g. one shared with the search.
+      Its current bounds are used, and its levels should then be pushed
+      and popped through the propagator.
+    */
+    IncrementalBoundPropagator( const InputQuery &query, BoundStore &store );
+    ~IncrementalBoundPropagator();
+
+    /*
+      Open a new decision level, or backtrack to the start of the
+      current one. Work that was still waiting to be propagated when a
+      level was opened is waiting again after it is popped.
+    */
+    void pushLevel();
+    void popLevel();
+    unsigned getLevel() const;
+
+    /*
+      Tighten a bound, e.g. as a result of a case split. Returns true if
+      the bound changed. The change is propagated by the next call to
+      propagate().
+    */
+    bool tightenLowerBound( unsigned variable, double value );
+    bool tightenUpperBound( unsigned variable, double value );
+
+    /*
+      Propagate all pending bound changes to a fixed point. Returns
+      false if a conflict (an empty domain) was found, in which case the
+      caller should backtrack.
+    */
+    bool propagate();
+
+    double getLowerBound( unsigned variable ) const;
+    double getUpperBound( unsigned variable ) const;
+    BoundStore &getBoundStore();
+
+    /*
+      Keep the activities in sync while the store backtracks.
+    */
+    void boundRestored( unsigned variable, bool upper, double currentValue, double restoredValue );
+
+    /*
+      Recompute all activities from scratch, discarding accumulated
+      rounding errors.
+    */
+    void recomputeActivities();
+
+    /*
+      Statistics
+    */
+    unsigned long long getNumTightenings() const;
+    unsigned long long getNumEquationVisits() const;
+    unsigned long long getNumBacktrackedChanges() const;
+
+private:
+    /*
+      Equations in compressed sparse row form, and their occurrences
+      per variable. Addends with zero coefficients are left out.
+    */
+    unsigned _n;
+    unsigned _numEquations;
+    Vector<unsigned> _equationStart;
+    Vector<unsigned> _equationVariables;
+    Vector<double> _equationCoefficients;
+    Vector<double> _scalars;
+
+    Vector<unsigned> _occurrenceStart;
+    Vector<unsigned> _occurrenceEquations;
+    Vector<double> _occurrenceCoefficients;
+
+    /*
+      Piecewise linear constraints, their participating variables, and
+      the constraints each variable participates in.
+    */
+    Vector<PiecewiseLinearConstraint *> _constraints;
+    Vector<unsigned> _constraintStart;
+    Vector<unsigned> _constraintVariables;
+    Vector<unsigned> _variableConstraintStart;
+    Vector<unsigned> _variableConstraints;
+
+    /*
+      Current bounds.
+    */
+    BoundStore *_store;
+    bool _ownsStore;
+
+    /*
+      Activities: the finite part of the minimal and maximal value of
+      each equation's left hand side, and the number of addends that
+      contribute an infinite amount.
+    */
+    Vector<double> _minActivity;
+    Vector<double> _maxActivity;
+    Vector<unsigned> _minInfinite;
+    Vector<unsigned> _maxInfinite;
+
+    /*
+      Equations and constraints waiting to be revisited.
+    */
+    Vector<unsigned> _dirtyEquations;
+    Vector<char> _equationIsDirty;
+    Vector<unsigned> _dirtyConstraints;
+    Vector<char> _constraintIsDirty;
+
+    /*
+      Set when a domain becomes empty, until the next backtrack.
+    */
+    bool _inConflict;
+
+    /*
+      The waiting work and conflict flag at the start of each level
+      opened through the propagator, restored when it is popped.
+    */
+    struct PendingWork
+    {
+        Vector<unsigned> _dirtyEquations;
+        Vector<unsigned> _dirtyConstraints;
+        bool _inConflict;
+    };
+
+    Vector<PendingWork> _pendingAtLevel;
+
+    unsigned long long _numTightenings;
+    unsigned long long _numEquationVisits;
+    unsigned long long _numBacktrackedChanges;
+
+    void initialize( const InputQuery &query );
+    void setBound( unsigned variable, bool upper, double value );
+    void updateActivities( unsigned variable, bool upper, double oldValue, double newValue );
+    void markDirty( unsigned variable );
+
+    bool propagateEquation( unsigned equation );
+    bool propagateConstraint( unsigned constraint );
+};
+
+#endif // __IncrementalBoundPropagator_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
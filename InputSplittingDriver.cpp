@@ -0,0 +1,310 @@
+/*********************                                                        */
+/*! \file InputSplittingDriver.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "BoundPropagator.h"
+#include "BoundStore.h"
+#include "Debug.h"
+#include "FloatUtils.h"
+#include "InfeasibleQueryException.h"
+#include "InputSplittingDriver.h"
+#include "Map.h"
+
+#include <thread>
+
+InputSplittingDriver::BoxSolver::BoxSolver( InputSplittingDriver &driver )
+    : _driver( driver )
+{
+}
+
+ParallelSplitSearch::Solver::Outcome InputSplittingDriver::BoxSolver::solve( unsigned worker,
+                                                                             BoundStore &bounds,
+                                                                             BasisFactorization &factorization,
+                                                                             List<List<Tightening> > &caseSplits )
+{
+    ++_driver._numBoxes;
+
+    if ( !_driver.propagate( bounds ) )
+    {
+        ++_driver._numClosedByPropagation;
+        return NODE_UNSAT;
+    }
+
+    unsigned numInputs = _driver._inputVariables.size();
+    unsigned split = numInputs;
+    if ( _driver._search->getCurrentDepth( worker ) < _driver._maxDepth )
+        split = _driver.chooseSplit( bounds );
+
+    if ( split == numInputs )
+    {
+        ++_driver._numLeaves;
+
+        if ( !_driver._leafSolvers.empty() )
+            return _driver._leafSolvers[worker]->solve( worker, bounds, factorization, caseSplits );
+
+        // Not refuted, only set aside: run() reports UNKNOWN if any box
+        // remains open
+        SubBox box;
+        for ( unsigned i = 0; i < _driver._n; ++i )
+        {
+            box._lowerBounds.append( bounds.getLowerBound( i ) );
+            box._upperBounds.append( bounds.getUpperBound( i ) );
+        }
+
+        std::unique_lock<std::mutex> lock( _driver._openBoxesMutex );
+        _driver._openBoxes.append( box );
+        return NODE_UNSAT;
+    }
+
+    unsigned variable = _driver._inputVariables[split];
+    double middle = ( bounds.getLowerBound( variable ) + bounds.getUpperBound( variable ) ) / 2;
+
+    List<Tightening> lowerHalf;
+    lowerHalf.append( Tightening( variable, middle, Tightening::UB ) );
+    caseSplits.append( lowerHalf );
+
+    List<Tightening> upperHalf;
+    upperHalf.append( Tightening( variable, middle, Tightening::LB ) );
+    caseSplits.append( upperHalf );
+
+    return NODE_SPLIT;
+}
+
+InputSplittingDriver::InputSplittingDriver( const InputQuery &query, const List<unsigned> &inputVariables )
+    : _query( query )
+    , _n( query.getNumberOfVariables() )
+    , _maxDepth( DEFAULT_MAX_DEPTH )
+    , _minimalWidth( 0 )
+    , _search( NULL )
+    , _numBoxes( 0 )
+    , _numClosedByPropagation( 0 )
+    , _numLeaves( 0 )
+{
+    Map<unsigned, unsigned> inputIndex;
+    for ( unsigned variable : inputVariables )
+    {
+        ASSERT( variable < _n );
+        inputIndex[variable] = _inputVariables.size();
+        _inputVariables.append( variable );
+        _influence.append( 0.0 );
+    }
+
+    for ( const auto &equation : _query.getEquations() )
+        for ( const auto &addend : equation._addends )
+            if ( inputIndex.exists( addend._variable ) )
+                _influence[inputIndex[addend._variable]] += FloatUtils::abs( addend._coefficient );
+}
+
+InputSplittingDriver::~InputSplittingDriver()
+{
+}
+
+void InputSplittingDriver::setMaxDepth( unsigned maxDepth )
+{
+    _maxDepth = maxDepth;
+}
+
+void InputSplittingDriver::setMinimalWidth( double minimalWidth )
+{
+    _minimalWidth = minimalWidth;
+}
+
+void InputSplittingDriver::setLeafSolvers( const Vector<ParallelSplitSearch::Solver *> &leafSolvers )
+{
+    _leafSolvers = leafSolvers;
+}
+
+bool InputSplittingDriver::propagate( BoundStore &bounds ) const
+{
+    // The constraints are notified of the box's bounds, so every box
+    // needs its own copies of them. The equations are only read.
+    List<PiecewiseLinearConstraint *> constraints;
+    for ( const auto &constraint : _query.getPiecewiseLinearConstraints() )
+        constraints.append( constraint->duplicateConstraint() );
+
+    BoundPropagator propagator( bounds );
+    const List<Equation> &equations( _query.getEquations() );
+
+    bool feasible = true;
+    try
+    {
+        bool continueTightening = true;
+        while ( continueTightening )
+        {
+            continueTightening = propagator.processEquations( equations );
+            continueTightening = propagator.processConstraints( constraints ) || continueTightening;
+        }
+    }
+    catch ( const InfeasibleQueryException & )
+    {
+        feasible = false;
+    }
+
+    for ( const auto &constraint : constraints )
+        delete constraint;
+
+    return feasible;
+}
+
+unsigned InputSplittingDriver::chooseSplit( const BoundStore &bounds ) const
+{
+    unsigned best = _inputVariables.size();
+    double bestSensitivity = 0;
+
+    for ( unsigned i = 0; i < _inputVariables.size(); ++i )
+    {
+        double lowerBound = bounds.getLowerBound( _inputVariables[i] );
+        double upperBound = bounds.getUpperBound( _inputVariables[i] );
+
+        // An unbounded input has no midpoint
+        if ( !FloatUtils::isFinite( lowerBound ) || !FloatUtils::isFinite( upperBound ) )
+            continue;
+
+        double width = upperBound - lowerBound;
+        if ( !FloatUtils::gt( width, _minimalWidth ) )
+            continue;
+
+        // Inputs that no equation uses still get split, but last
+        double sensitivity = width * ( _influence[i] + 1e-6 );
+        if ( sensitivity > bestSensitivity )
+        {
+            bestSensitivity = sensitivity;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+InputSplittingDriver::Result InputSplittingDriver::run( unsigned numberOfThreads )
+{
+    _openBoxes.clear();
+    _numBoxes = 0;
+    _numClosedByPropagation = 0;
+    _numLeaves = 0;
+
+    unsigned numWorkers = _leafSolvers.size();
+    if ( numWorkers == 0 )
+    {
+        numWorkers = numberOfThreads;
+        if ( numWorkers == 0 )
+            numWorkers = std::thread::hardware_concurrency();
+        if ( numWorkers == 0 )
+            numWorkers = 1;
+    }
+
+    Vector<BoxSolver *> boxSolvers;
+    Vector<ParallelSplitSearch::Solver *> solvers;
+    for ( unsigned i = 0; i < numWorkers; ++i )
+    {
+        boxSolvers.append( new BoxSolver( *this ) );
+        solvers.append( boxSolvers[i] );
+    }
+
+    // Without leaf solvers nothing uses the factorization, so keep the
+    // checkpoints trivial
+    unsigned m = 1;
+    if ( !_leafSolvers.empty() && !_query.getEquations().empty() )
+        m = _query.getEquations().size();
+
+    ParallelSplitSearch::Result result;
+    try
+    {
+        ParallelSplitSearch search( _query, m, solvers );
+        {
+            std::unique_lock<std::mutex> lock( _searchMutex );
+            _search = &search;
+        }
+
+        try
+        {
+            result = search.run();
+        }
+        catch ( ... )
+        {
+            std::unique_lock<std::mutex> lock( _searchMutex );
+            _search = NULL;
+            throw;
+        }
+
+        std::unique_lock<std::mutex> lock( _searchMutex );
+        _search = NULL;
+    }
+    catch ( ... )
+    {
+        for ( auto &boxSolver : boxSolvers )
+            delete boxSolver;
+        throw;
+    }
+
+    for ( auto &boxSolver : boxSolvers )
+        delete boxSolver;
+
+    if ( result == ParallelSplitSearch::SAT )
+        return SAT;
+
+    if ( result == ParallelSplitSearch::UNSAT && _openBoxes.empty() )
+        return UNSAT;
+
+    return UNKNOWN;
+}
+
+void InputSplittingDriver::requestStop()
+{
+    std::unique_lock<std::mutex> lock( _searchMutex );
+    if ( _search )
+        _search->requestStop();
+}
+
+const List<InputSplittingDriver::SubBox> &InputSplittingDriver::getOpenBoxes() const
+{
+    return _openBoxes;
+}
+
+InputQuery InputSplittingDriver::materialize( const SubBox &box ) const
+{
+    ASSERT( box._lowerBounds.size() == _n );
+
+    InputQuery query = _query;
+    for ( unsigned i = 0; i < _n; ++i )
+    {
+        if ( box._lowerBounds[i] != query.getLowerBound( i ) )
+            query.setLowerBound( i, box._lowerBounds[i] );
+
+        if ( box._upperBounds[i] != query.getUpperBound( i ) )
+            query.setUpperBound( i, box._upperBounds[i] );
+    }
+
+    return query;
+}
+
+unsigned long long InputSplittingDriver::getNumBoxes() const
+{
+    return _numBoxes;
+}
+
+unsigned long long InputSplittingDriver::getNumClosedByPropagation() const
+{
+    return _numClosedByPropagation;
+}
+
+unsigned long long InputSplittingDriver::getNumLeaves() const
+{
+    return _numLeaves;
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
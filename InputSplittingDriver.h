@@ -0,0 +1,179 @@
+/*********************                                                        */
+/*! \file InputSplittingDriver.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __InputSplittingDriver_h__
+#define __InputSplittingDriver_h__
+
+#include "InputQuery.h"
+#include "List.h"
+#include "ParallelSplitSearch.h"
+#include "Vector.h"
+
+#include <atomic>
+#include <mutex>
+
+/*
+  Solves a query by splitting its input region. When the input box is
+  large, propagation gives loose bounds on the hidden neurons; on
+  smaller boxes it is much more precise, and often enough to refute a
+  box without any search.
+
+  Every sub-box is a node of a ParallelSplitSearch, so the boxes are
+  preprocessed in parallel and refined on its work-stealing pool. For
+  each box, bounds are propagated through the network. A box is closed
+  if propagation finds it infeasible. Otherwise it is split in half
+  along the input dimension with the highest sensitivity, until a
+  maximal depth or a minimal width is reached. The remaining hard boxes
+  are either handed to leaf solvers (e.g. the full engine), or
+  collected for the caller.
+
+  The sensitivity of an input is its current width times the sum of
+  the absolute coefficients with which it enters the equations, i.e. a
+  first-order estimate of how much the bounds of the first layer widen
+  because of it.
+*/
+class InputSplittingDriver
+{
+public:
+    enum Result {
+        UNSAT = 0,
+        SAT = 1,
+        UNKNOWN = 2,
+    };
+
+    /*
+      A box that propagation could not close, with the bounds of all
+      variables after propagation.
+    */
+    struct SubBox
+    {
+        Vector<double> _lowerBounds;
+        Vector<double> _upperBounds;
+    };
+
+    enum {
+        DEFAULT_MAX_DEPTH = 16,
+    };
+
+    /*
+      The network and property, and the variables that span the input
+      region.
+    */
+    InputSplittingDriver( const InputQuery &query, const List<unsigned> &inputVariables );
+    ~InputSplittingDriver();
+
+    /*
+      Splitting stops at this depth, or when no input is wider than the
+      minimal width.
+    */
+    void setMaxDepth( unsigned maxDepth );
+    void setMinimalWidth( double minimalWidth );
+
+    /*
+      Optional solvers for the hard boxes, one per worker. Without them,
+      hard boxes are collected and the result is UNKNOWN unless every
+      box was closed.
+    */
+    void setLeafSolvers( const Vector<ParallelSplitSearch::Solver *> &leafSolvers );
+
+    /*
+      Run with the given number of workers (0 means one per hardware
+      thread), or with one worker per leaf solver if there are any. An
+      exception thrown by a leaf solver is rethrown once the workers
+      are done.
+    */
+    Result run( unsigned numberOfThreads = 0 );
+
+    /*
+      Stop a running search, from any thread.
+    */
+    void requestStop();
+
+    /*
+      The hard boxes that were not handed to a leaf solver, and the
+      query restricted to one of them.
+    */
+    const List<SubBox> &getOpenBoxes() const;
+    InputQuery materialize( const SubBox &box ) const;
+
+    /*
+      Statistics
+    */
+    unsigned long long getNumBoxes() const;
+    unsigned long long getNumClosedByPropagation() const;
+    unsigned long long getNumLeaves() const;
+
+private:
+    /*
+      Propagates and splits the boxes of one worker.
+    */
+    class BoxSolver : public ParallelSplitSearch::Solver
+    {
+    public:
+        BoxSolver( InputSplittingDriver &driver );
+        Outcome solve( unsigned worker,
+                       BoundStore &bounds,
+                       BasisFactorization &factorization,
+                       List<List<Tightening> > &caseSplits );
+
+    private:
+        InputSplittingDriver &_driver;
+    };
+
+    const InputQuery &_query;
+    unsigned _n;
+    Vector<unsigned> _inputVariables;
+
+    /*
+      Per input: the sum of the absolute coefficients of its addends.
+    */
+    Vector<double> _influence;
+
+    unsigned _maxDepth;
+    double _minimalWidth;
+    Vector<ParallelSplitSearch::Solver *> _leafSolvers;
+
+    /*
+      The running search, guarded so that requestStop() never sees it
+      half destroyed.
+    */
+    ParallelSplitSearch *_search;
+    std::mutex _searchMutex;
+
+    std::mutex _openBoxesMutex;
+    List<SubBox> _openBoxes;
+
+    std::atomic<unsigned long long> _numBoxes;
+    std::atomic<unsigned long long> _numClosedByPropagation;
+    std::atomic<unsigned long long> _numLeaves;
+
+    /*
+      Returns false if the box is infeasible.
+    */
+    bool propagate( BoundStore &bounds ) const;
+
+    /*
+      Returns the index (in _inputVariables) of the input to split, or
+      _inputVariables.size() if none is wide enough.
+    */
+    unsigned chooseSplit( const BoundStore &bounds ) const;
+};
+
+#endif // __InputSplittingDriver_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
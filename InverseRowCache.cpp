@@ -0,0 +1,265 @@
+/*********************                                                        */
+/*! \file InverseRowCache.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "Debug.h"
+#include "FloatUtils.h"
+#include "InverseRowCache.h"
+#include "ReluplexError.h"
+
+#include <algorithm>
+
+InverseRowCache::InverseRowCache( unsigned m, unsigned capacity )
+    : _m( m )
+    , _capacity( std::min( capacity, m ) )
+    , _rows( NULL )
+    , _rowOfSlot( NULL )
+    , _lastUse( NULL )
+    , _slotOfRow( NULL )
+    , _size( 0 )
+    , _clock( 0 )
+    , _pivotRow( NULL )
+    , _numHits( 0 )
+    , _numMisses( 0 )
+    , _numRowUpdates( 0 )
+    , _numUpdateTransformations( 0 )
+{
+}
+
+InverseRowCache::~InverseRowCache()
+{
+    freeIfNeeded();
+}
+
+void InverseRowCache::allocate()
+{
+    _rows = new double[_capacity * _m];
+    if ( !_rows )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "InverseRowCache::rows" );
+
+    _rowOfSlot = new unsigned[_capacity];
+    if ( !_rowOfSlot )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "InverseRowCache::rowOfSlot" );
+
+    _lastUse = new unsigned long long[_capacity];
+    if ( !_lastUse )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "InverseRowCache::lastUse" );
+
+    _slotOfRow = new unsigned[_m];
+    if ( !_slotOfRow )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "InverseRowCache::slotOfRow" );
+
+    _pivotRow = new double[_m];
+    if ( !_pivotRow )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "InverseRowCache::pivotRow" );
+
+    std::fill_n( _slotOfRow, _m, _capacity );
+    _size = 0;
+}
+
+void InverseRowCache::freeIfNeeded()
+{
+    if ( _rows )
+    {
+        delete[] _rows;
+        _rows = NULL;
+    }
+
+    if ( _rowOfSlot )
+    {
+        delete[] _rowOfSlot;
+        _rowOfSlot = NULL;
+    }
+
+    if ( _lastUse )
+    {
+        delete[] _lastUse;
+        _lastUse = NULL;
+    }
+
+    if ( _slotOfRow )
+    {
+        delete[] _slotOfRow;
+        _slotOfRow = NULL;
+    }
+
+    if ( _pivotRow )
+    {
+        delete[] _pivotRow;
+        _pivotRow = NULL;
+    }
+
+    _size = 0;
+}
+
+unsigned InverseRowCache::getCapacity() const
+{
+    return _capacity;
+}
+
+void InverseRowCache::setCapacity( unsigned capacity )
+{
+    freeIfNeeded();
+    _capacity = std::min( capacity, _m );
+}
+
+bool InverseRowCache::empty() const
+{
+    return _size == 0;
+}
+
+bool InverseRowCache::contains( unsigned row ) const
+{
+    ASSERT( row < _m );
+    return _slotOfRow && ( _slotOfRow[row] < _capacity );
+}
+
+const double *InverseRowCache::find( unsigned row )
+{
+    if ( !contains( row ) )
+    {
+        ++_numMisses;
+        return NULL;
+    }
+
+    ++_numHits;
+
+    unsigned slot = _slotOfRow[row];
+    _lastUse[slot] = ++_clock;
+    return _rows + slot * _m;
+}
+
+const double *InverseRowCache::peek( unsigned row ) const
+{
+    return contains( row ) ? _rows + _slotOfRow[row] * _m : NULL;
+}
+
+double *InverseRowCache::insert( unsigned row )
+{
+    ASSERT( _capacity > 0 );
+    ASSERT( !contains( row ) );
+
+    if ( !_rows )
+        allocate();
+
+    unsigned slot;
+    if ( _size < _capacity )
+    {
+        slot = _size;
+        ++_size;
+    }
+    else
+    {
+        slot = 0;
+        for ( unsigned i = 1; i < _capacity; ++i )
+        {
+            if ( _lastUse[i] < _lastUse[slot] )
+                slot = i;
+        }
+
+        _slotOfRow[_rowOfSlot[slot]] = _capacity;
+    }
+
+    _rowOfSlot[slot] = row;
+    _slotOfRow[row] = slot;
+    _lastUse[slot] = ++_clock;
+    return _rows + slot * _m;
+}
+
+void InverseRowCache::update( unsigned columnIndex, const double *column, const double *leavingRow )
+{
+    ASSERT( !FloatUtils::isZero( column[columnIndex] ) );
+
+    if ( _size == 0 )
+        return;
+
+    // B' = B * E, so inv(B') = inv(E) * inv(B). The leaving row is
+    // divided by the pivot, and every other row r loses column[r]
+    // times the new leaving row.
+    double pivot = column[columnIndex];
+    for ( unsigned i = 0; i < _m; ++i )
+    {
+        _pivotRow[i] = leavingRow[i] / pivot;
+        if ( FloatUtils::isZero( _pivotRow[i] ) )
+            _pivotRow[i] = 0.0;
+    }
+
+    for ( unsigned slot = 0; slot < _size; ++slot )
+    {
+        unsigned row = _rowOfSlot[slot];
+        double *cached = _rows + slot * _m;
+
+        if ( row == columnIndex )
+        {
+            std::copy( _pivotRow, _pivotRow + _m, cached );
+        }
+        else if ( column[row] != 0.0 )
+        {
+            double factor = column[row];
+            for ( unsigned i = 0; i < _m; ++i )
+            {
+                cached[i] -= factor * _pivotRow[i];
+                if ( FloatUtils::isZero( cached[i] ) )
+                    cached[i] = 0.0;
+            }
+        }
+
+        ++_numRowUpdates;
+    }
+}
+
+void InverseRowCache::invalidate()
+{
+    if ( !_slotOfRow )
+        return;
+
+    for ( unsigned slot = 0; slot < _size; ++slot )
+        _slotOfRow[_rowOfSlot[slot]] = _capacity;
+    _size = 0;
+}
+
+unsigned long long InverseRowCache::getNumHits() const
+{
+    return _numHits;
+}
+
+unsigned long long InverseRowCache::getNumMisses() const
+{
+    return _numMisses;
+}
+
+unsigned long long InverseRowCache::getNumRowUpdates() const
+{
+    return _numRowUpdates;
+}
+
+unsigned long long InverseRowCache::getNumUpdateTransformations() const
+{
+    return _numUpdateTransformations;
+}
+
+long long InverseRowCache::getNumSavedTransformations() const
+{
+    return (long long)_numHits - (long long)_numUpdateTransformations;
+}
+
+void InverseRowCache::countUpdateTransformation()
+{
+    ++_numUpdateTransformations;
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
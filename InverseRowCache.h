@@ -0,0 +1,143 @@
+/*********************                                                        */
+/*! \file InverseRowCache.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __InverseRowCache_h__
+#define __InverseRowCache_h__
+
+/*
+  A bounded cache of rows of inv(B), for a basis matrix B of dimension
+  m, keyed by row index. When the least recently used row has to make
+  room for a new one, it is evicted.
+
+  When an eta matrix E is pushed, the new inverse is inv(E) * inv(B),
+  so every cached row can be brought up to date in O(m) from the row
+  of the leaving column, instead of being recomputed by a backward
+  transformation.
+*/
+class InverseRowCache
+{
+public:
+    enum {
+        DEFAULT_CAPACITY = 32,
+    };
+
+    InverseRowCache( unsigned m, unsigned capacity = DEFAULT_CAPACITY );
+    ~InverseRowCache();
+
+    /*
+      Free any allocated memory. The cached rows are lost.
+    */
+    void freeIfNeeded();
+
+    /*
+      The maximal number of cached rows; 0 disables the cache. Changing
+      it drops the cached rows.
+    */
+    unsigned getCapacity() const;
+    void setCapacity( unsigned capacity );
+
+    bool empty() const;
+    bool contains( unsigned row ) const;
+
+    /*
+      The cached row, or NULL if it is not cached. Counts as a hit or
+      a miss.
+    */
+    const double *find( unsigned row );
+
+    /*
+      The cached row, or NULL, without counting the lookup or marking
+      the row as used.
+    */
+    const double *peek( unsigned row ) const;
+
+    /*
+      Make room for a row, evicting the least recently used one if the
+      cache is full, and return the storage that the caller must fill.
+    */
+    double *insert( unsigned row );
+
+    /*
+      Bring the cached rows up to date after an eta matrix with the
+      given column is pushed. leavingRow is row columnIndex of the
+      inverse before the push.
+    */
+    void update( unsigned columnIndex, const double *column, const double *leavingRow );
+
+    /*
+      Drop all cached rows, e.g. when the basis is refactorized.
+    */
+    void invalidate();
+
+    /*
+      Statistics: lookups that hit and missed, cached rows updated in
+      place, and the backward transformations performed by updates to
+      obtain a leaving row that was not cached. Each hit saves a
+      backward transformation, so the number saved is the hits minus
+      the update transformations.
+    */
+    unsigned long long getNumHits() const;
+    unsigned long long getNumMisses() const;
+    unsigned long long getNumRowUpdates() const;
+    unsigned long long getNumUpdateTransformations() const;
+    long long getNumSavedTransformations() const;
+
+    /*
+      Called by the owner whenever it computes a leaving row for an
+      update.
+    */
+    void countUpdateTransformation();
+
+private:
+    unsigned _m;
+    unsigned _capacity;
+
+    /*
+      The rows, capacity x m, allocated on the first insertion. For
+      each slot, the row it holds (or m if it is free) and when it was
+      last used; for each row, its slot (or capacity if not cached).
+    */
+    double *_rows;
+    unsigned *_rowOfSlot;
+    unsigned long long *_lastUse;
+    unsigned *_slotOfRow;
+    unsigned _size;
+    unsigned long long _clock;
+
+    /*
+      Working space for the new leaving row.
+    */
+    double *_pivotRow;
+
+    unsigned long long _numHits;
+    unsigned long long _numMisses;
+    unsigned long long _numRowUpdates;
+    unsigned long long _numUpdateTransformations;
+
+    void allocate();
+
+    /*
+      Not copyable.
+    */
+    InverseRowCache( const InverseRowCache &other );
+    InverseRowCache &operator=( const InverseRowCache &other );
+};
+
+#endif // __InverseRowCache_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
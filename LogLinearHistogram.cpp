@@ -0,0 +1,158 @@
+/*********************                                                        */
+/*! \file LogLinearHistogram.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "Debug.h"
+#include "LogLinearHistogram.h"
+
+#include <cmath>
+
+LogLinearHistogram::LogLinearHistogram()
+{
+    reset();
+}
+
+LogLinearHistogram::LogLinearHistogram( const LogLinearHistogram &other )
+{
+    reset();
+    merge( other );
+}
+
+LogLinearHistogram &LogLinearHistogram::operator=( const LogLinearHistogram &other )
+{
+    if ( this != &other )
+    {
+        reset();
+        merge( other );
+    }
+
+    return *this;
+}
+
+void LogLinearHistogram::merge( const LogLinearHistogram &other )
+{
+    for ( unsigned i = 0; i < NUM_BUCKETS; ++i )
+    {
+        unsigned long long count = other._counts[i].load( std::memory_order_relaxed );
+        if ( count > 0 )
+            _counts[i].fetch_add( count, std::memory_order_relaxed );
+    }
+
+    _count.fetch_add( other._count.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+    _sum.fetch_add( other._sum.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+
+    unsigned long long otherMax = other._max.load( std::memory_order_relaxed );
+    if ( otherMax > _max.load( std::memory_order_relaxed ) )
+        _max.store( otherMax, std::memory_order_relaxed );
+}
+
+void LogLinearHistogram::reset()
+{
+    for ( unsigned i = 0; i < NUM_BUCKETS; ++i )
+        _counts[i].store( 0, std::memory_order_relaxed );
+
+    _count.store( 0, std::memory_order_relaxed );
+    _sum.store( 0, std::memory_order_relaxed );
+    _max.store( 0, std::memory_order_relaxed );
+}
+
+unsigned long long LogLinearHistogram::getCount() const
+{
+    return _count.load( std::memory_order_relaxed );
+}
+
+unsigned long long LogLinearHistogram::getSum() const
+{
+    return _sum.load( std::memory_order_relaxed );
+}
+
+unsigned long long LogLinearHistogram::getMax() const
+{
+    return _max.load( std::memory_order_relaxed );
+}
+
+double LogLinearHistogram::getMean() const
+{
+    unsigned long long count = getCount();
+    if ( count == 0 )
+        return 0;
+
+    return (double)getSum() / count;
+}
+
+unsigned long long LogLinearHistogram::getPercentile( double percentile ) const
+{
+    unsigned long long count = getCount();
+    if ( count == 0 )
+        return 0;
+
+    unsigned long long target = (unsigned long long)std::ceil( percentile / 100 * count );
+    if ( target == 0 )
+        target = 1;
+
+    unsigned long long seen = 0;
+    for ( unsigned i = 0; i < NUM_BUCKETS; ++i )
+    {
+        seen += _counts[i].load( std::memory_order_relaxed );
+        if ( seen >= target )
+        {
+            // Never report more than was actually recorded
+            unsigned long long upper = getBucketUpperValue( i );
+            unsigned long long max = getMax();
+            return upper < max ? upper : max;
+        }
+    }
+
+    return getMax();
+}
+
+unsigned LogLinearHistogram::getBucket( unsigned long long value )
+{
+    if ( value < SUB_BUCKETS )
+        return value;
+
+    // The position of the highest set bit, at least SUB_BUCKET_BITS
+    unsigned exponent = 63 - __builtin_clzll( value );
+    unsigned shift = exponent - SUB_BUCKET_BITS;
+    unsigned subBucket = ( value >> shift ) - SUB_BUCKETS;
+
+    return SUB_BUCKETS + shift * SUB_BUCKETS + subBucket;
+}
+
+unsigned long long LogLinearHistogram::getBucketLowerValue( unsigned bucket )
+{
+    ASSERT( bucket < NUM_BUCKETS );
+
+    if ( bucket < SUB_BUCKETS )
+        return bucket;
+
+    unsigned shift = ( bucket - SUB_BUCKETS ) / SUB_BUCKETS;
+    unsigned subBucket = ( bucket - SUB_BUCKETS ) % SUB_BUCKETS;
+
+    return (unsigned long long)( SUB_BUCKETS + subBucket ) << shift;
+}
+
+unsigned long long LogLinearHistogram::getBucketUpperValue( unsigned bucket )
+{
+    if ( bucket < SUB_BUCKETS )
+        return bucket;
+
+    unsigned shift = ( bucket - SUB_BUCKETS ) / SUB_BUCKETS;
+    return getBucketLowerValue( bucket ) + ( ( 1ULL << shift ) - 1 );
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,93 @@
+/*********************                                                        */
+/*! \file LogLinearHistogram.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __LogLinearHistogram_h__
+#define __LogLinearHistogram_h__
+
+#include <atomic>
+
+/*
+  A histogram of non-negative integers over the full 64-bit range, in
+  the style of HdrHistogram: values below SUB_BUCKETS are counted
+  exactly, and every power-of-two range above is split into
+  SUB_BUCKETS linear buckets, so any recorded value is known to within
+  1/SUB_BUCKETS of itself. This is enough for meaningful p50 and p99
+  figures at a fixed, small size.
+
+  A histogram has a single writer, but may be read (e.g. merged) from
+  other threads at any time; the counts are atomics that the writer
+  updates without read-modify-write instructions.
+*/
+class LogLinearHistogram
+{
+public:
+    enum {
+        SUB_BUCKET_BITS = 4,
+        SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+        NUM_BUCKETS = SUB_BUCKETS + ( 64 - SUB_BUCKET_BITS ) * SUB_BUCKETS,
+    };
+
+    LogLinearHistogram();
+    LogLinearHistogram( const LogLinearHistogram &other );
+    LogLinearHistogram &operator=( const LogLinearHistogram &other );
+
+    /*
+      Record a value. Only the owning thread may call this.
+    */
+    void record( unsigned long long value )
+    {
+        unsigned bucket = getBucket( value );
+        _counts[bucket].store( _counts[bucket].load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+        _count.store( _count.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+        _sum.store( _sum.load( std::memory_order_relaxed ) + value, std::memory_order_relaxed );
+
+        if ( value > _max.load( std::memory_order_relaxed ) )
+            _max.store( value, std::memory_order_relaxed );
+    }
+
+    /*
+      Add the counts of another histogram to this one.
+    */
+    void merge( const LogLinearHistogram &other );
+    void reset();
+
+    unsigned long long getCount() const;
+    unsigned long long getSum() const;
+    unsigned long long getMax() const;
+    double getMean() const;
+
+    /*
+      The smallest value v such that at least the given percentage of
+      the recorded values are at most v, up to the bucket resolution.
+    */
+    unsigned long long getPercentile( double percentile ) const;
+
+    static unsigned getBucket( unsigned long long value );
+    static unsigned long long getBucketLowerValue( unsigned bucket );
+    static unsigned long long getBucketUpperValue( unsigned bucket );
+
+private:
+    std::atomic<unsigned long long> _counts[NUM_BUCKETS];
+    std::atomic<unsigned long long> _count;
+    std::atomic<unsigned long long> _sum;
+    std::atomic<unsigned long long> _max;
+};
+
+#endif // __LogLinearHistogram_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
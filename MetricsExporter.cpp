@@ -0,0 +1,493 @@
+/*********************                                                        */
+/*! \file MetricsExporter.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "CommonError.h"
+#include "Debug.h"
+#include "MStringf.h"
+#include "MetricsExporter.h"
+#include "OperationTimers.h"
+#include "PerfCounters.h"
+#include "Preprocessor.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+    String escape( const String &text )
+    {
+        String result;
+        for ( const char *c = text.ascii(); *c; ++c )
+        {
+            if ( *c == '"' || *c == '\\' )
+                result += "\\";
+
+            if ( *c == '\n' )
+                result += "\\n";
+            else
+                result += Stringf( "%c", *c );
+        }
+
+        return result;
+    }
+
+    String formatValue( double value, bool json )
+    {
+        if ( std::isnan( value ) )
+            return json ? "null" : "NaN";
+
+        if ( std::isinf( value ) )
+        {
+            if ( json )
+                return "null";
+            return value > 0 ? "+Inf" : "-Inf";
+        }
+
+        return Stringf( "%.17g", value );
+    }
+
+    const char *getTypeName( MetricsSnapshot::Type type )
+    {
+        switch ( type )
+        {
+        case MetricsSnapshot::COUNTER:
+            return "counter";
+        case MetricsSnapshot::GAUGE:
+            return "gauge";
+        case MetricsSnapshot::SUMMARY:
+            return "summary";
+        }
+
+        return "untyped";
+    }
+}
+
+void MetricsSnapshot::declare( const String &family, Type type, const String &help )
+{
+    if ( _familyIndex.exists( family ) )
+        return;
+
+    Family entry;
+    entry._name = family;
+    entry._type = type;
+    entry._help = help;
+
+    _familyIndex[family] = _families.size();
+    _families.append( entry );
+}
+
+void MetricsSnapshot::add( const String &family, double value, const Labels &labels )
+{
+    add( family, family, value, labels );
+}
+
+void MetricsSnapshot::add( const String &family, const String &name, double value, const Labels &labels )
+{
+    ASSERT( _familyIndex.exists( family ) );
+
+    Sample sample;
+    sample._name = name;
+    sample._labels = labels;
+    sample._value = value;
+
+    _families[_familyIndex[family]]._samples.append( sample );
+}
+
+const Vector<MetricsSnapshot::Family> &MetricsSnapshot::getFamilies() const
+{
+    return _families;
+}
+
+void MetricsSnapshot::clear()
+{
+    _families.clear();
+    _familyIndex.clear();
+}
+
+MetricsSnapshot::Labels MetricsSnapshot::label( const String &name, const String &value )
+{
+    Labels labels;
+    labels.append( std::make_pair( name, value ) );
+    return labels;
+}
+
+MetricsSnapshot::Labels MetricsSnapshot::label( const String &name, const String &value,
+                                                const String &name2, const String &value2 )
+{
+    Labels labels = label( name, value );
+    labels.append( std::make_pair( name2, value2 ) );
+    return labels;
+}
+
+MetricsExporter::MetricsExporter()
+    : _running( false )
+    , _format( JSON_LINES )
+    , _periodMilli( 0 )
+    , _numSnapshots( 0 )
+    , _numFailedWrites( 0 )
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+void MetricsExporter::addSource( const Source *source )
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    _sources.append( source );
+}
+
+void MetricsExporter::removeSource( const Source *source )
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    for ( auto it = _sources.begin(); it != _sources.end(); ++it )
+    {
+        if ( *it == source )
+        {
+            _sources.erase( it );
+            return;
+        }
+    }
+}
+
+void MetricsExporter::setPreprocessorStatistics( const Preprocessor &preprocessor )
+{
+    MetricsSnapshot metrics;
+    metrics.declare( "marabou_preprocessor_pass_iterations", MetricsSnapshot::GAUGE,
+                     "Tightening iterations run by each preprocessing pass" );
+    metrics.declare( "marabou_preprocessor_pass_bounds_tightened", MetricsSnapshot::GAUGE,
+                     "Bounds tightened by each preprocessing pass" );
+    metrics.declare( "marabou_preprocessor_pass_seconds", MetricsSnapshot::GAUGE,
+                     "Time spent in each preprocessing pass" );
+    metrics.declare( "marabou_preprocessor_iterations", MetricsSnapshot::GAUGE,
+                     "Tightening iterations run by all preprocessing passes" );
+    metrics.declare( "marabou_preprocessor_eliminated_variables", MetricsSnapshot::GAUGE,
+                     "Variables eliminated by preprocessing" );
+
+    unsigned iterations = 0;
+    unsigned eliminated = 0;
+    unsigned index = 0;
+    for ( const auto &pass : preprocessor.getPassStatistics() )
+    {
+        MetricsSnapshot::Labels labels = MetricsSnapshot::label( "pass", Preprocessor::getPassName( pass._type ),
+                                                                 "index", Stringf( "%u", index++ ) );
+
+        metrics.add( "marabou_preprocessor_pass_iterations", pass._numIterations, labels );
+        metrics.add( "marabou_preprocessor_pass_bounds_tightened", pass._numBoundsTightened, labels );
+        metrics.add( "marabou_preprocessor_pass_seconds", pass._timeMicro / 1000000.0, labels );
+
+        iterations += pass._numIterations;
+        eliminated += pass._numVariablesRemoved;
+    }
+
+    metrics.add( "marabou_preprocessor_iterations", iterations );
+    metrics.add( "marabou_preprocessor_eliminated_variables", eliminated );
+
+    std::unique_lock<std::mutex> lock( _mutex );
+    _preprocessorMetrics = metrics;
+}
+
+void MetricsExporter::collectOperationTimers( MetricsSnapshot &snapshot )
+{
+    snapshot.declare( "marabou_factorization_latency_seconds", MetricsSnapshot::SUMMARY,
+                      "Latency of basis factorization operations" );
+    snapshot.declare( "marabou_factorization_input_density", MetricsSnapshot::GAUGE,
+                      "Mean fraction of nonzero entries in the inputs of basis factorization operations" );
+    snapshot.declare( "marabou_factorization_output_density", MetricsSnapshot::GAUGE,
+                      "Mean fraction of nonzero entries in the outputs of basis factorization operations" );
+
+    double secondsPerTick = OperationTimers::getNanosecondsPerTick() / 1e9;
+
+    for ( unsigned i = 0; i < OperationTimers::NUM_OPERATIONS; ++i )
+    {
+        OperationTimers::Operation operation = (OperationTimers::Operation)i;
+        OperationTimers::Report report = OperationTimers::getReport( operation );
+        if ( report._latency.getCount() == 0 )
+            continue;
+
+        String name = OperationTimers::getOperationName( operation );
+        MetricsSnapshot::Labels labels = MetricsSnapshot::label( "operation", name );
+
+        static const double QUANTILES[] = { 0.5, 0.9, 0.99 };
+        for ( double quantile : QUANTILES )
+            snapshot.add( "marabou_factorization_latency_seconds",
+                          report._latency.getPercentile( quantile * 100 ) * secondsPerTick,
+                          MetricsSnapshot::label( "operation", name, "quantile", Stringf( "%g", quantile ) ) );
+
+        snapshot.add( "marabou_factorization_latency_seconds", "marabou_factorization_latency_seconds_sum",
+                      report._latency.getSum() * secondsPerTick, labels );
+        snapshot.add( "marabou_factorization_latency_seconds", "marabou_factorization_latency_seconds_count",
+                      report._latency.getCount(), labels );
+
+        if ( report._inputSize > 0 )
+            snapshot.add( "marabou_factorization_input_density",
+                          (double)report._inputNonZeros.getSum() / report._inputSize, labels );
+
+        if ( report._outputSize > 0 )
+            snapshot.add( "marabou_factorization_output_density",
+                          (double)report._outputNonZeros.getSum() / report._outputSize, labels );
+    }
+}
+
+void MetricsExporter::collectPerfCounters( MetricsSnapshot &snapshot )
+{
+    snapshot.declare( "marabou_hot_path_calls_total", MetricsSnapshot::COUNTER,
+                      "Calls of instrumented hot paths" );
+    snapshot.declare( "marabou_hot_path_events_total", MetricsSnapshot::COUNTER,
+                      "Hardware events counted in the sampled calls of instrumented hot paths" );
+
+    for ( unsigned i = 0; i < PerfCounters::NUM_CATEGORIES; ++i )
+    {
+        PerfCounters::Category category = (PerfCounters::Category)i;
+        PerfCounters::Totals totals = PerfCounters::getTotals( category );
+        if ( totals._calls == 0 )
+            continue;
+
+        String name = PerfCounters::getCategoryName( category );
+        snapshot.add( "marabou_hot_path_calls_total", totals._calls, MetricsSnapshot::label( "category", name ) );
+
+        if ( !PerfCounters::countersAvailable() )
+            continue;
+
+        for ( unsigned j = 0; j < PerfCounters::NUM_EVENTS; ++j )
+            snapshot.add( "marabou_hot_path_events_total", totals._events[j],
+                          MetricsSnapshot::label( "category", name,
+                                                  "event", PerfCounters::getEventName( (PerfCounters::Event)j ) ) );
+    }
+}
+
+void MetricsExporter::collect( MetricsSnapshot &snapshot ) const
+{
+    collectOperationTimers( snapshot );
+    collectPerfCounters( snapshot );
+
+    std::unique_lock<std::mutex> lock( _mutex );
+
+    for ( const auto &family : _preprocessorMetrics.getFamilies() )
+    {
+        snapshot.declare( family._name, family._type, family._help );
+        for ( const auto &sample : family._samples )
+            snapshot.add( family._name, sample._name, sample._value, sample._labels );
+    }
+
+    for ( const auto &source : _sources )
+        source->collectMetrics( snapshot );
+}
+
+String MetricsExporter::toJson( const MetricsSnapshot &snapshot, unsigned long long timestampMilli )
+{
+    String result = Stringf( "{\"timestamp_ms\":%llu,\"metrics\":[", timestampMilli );
+
+    bool first = true;
+    for ( const auto &family : snapshot.getFamilies() )
+    {
+        for ( const auto &sample : family._samples )
+        {
+            if ( !first )
+                result += ",";
+            first = false;
+
+            result += Stringf( "{\"name\":\"%s\",\"type\":\"%s\",\"labels\":{",
+                               escape( sample._name ).ascii(),
+                               getTypeName( family._type ) );
+
+            bool firstLabel = true;
+            for ( const auto &label : sample._labels )
+            {
+                if ( !firstLabel )
+                    result += ",";
+                firstLabel = false;
+
+                result += Stringf( "\"%s\":\"%s\"", escape( label.first ).ascii(), escape( label.second ).ascii() );
+            }
+
+            result += "},\"value\":";
+            result += formatValue( sample._value, true );
+            result += "}";
+        }
+    }
+
+    result += "]}\n";
+    return result;
+}
+
+String MetricsExporter::toPrometheus( const MetricsSnapshot &snapshot )
+{
+    String result;
+
+    for ( const auto &family : snapshot.getFamilies() )
+    {
+        if ( family._samples.empty() )
+            continue;
+
+        result += Stringf( "# HELP %s %s\n", family._name.ascii(), family._help.ascii() );
+        result += Stringf( "# TYPE %s %s\n", family._name.ascii(), getTypeName( family._type ) );
+
+        for ( const auto &sample : family._samples )
+        {
+            result += sample._name;
+
+            if ( !sample._labels.empty() )
+            {
+                result += "{";
+
+                bool firstLabel = true;
+                for ( const auto &label : sample._labels )
+                {
+                    if ( !firstLabel )
+                        result += ",";
+                    firstLabel = false;
+
+                    result += Stringf( "%s=\"%s\"", label.first.ascii(), escape( label.second ).ascii() );
+                }
+
+                result += "}";
+            }
+
+            result += " ";
+            result += formatValue( sample._value, false );
+            result += "\n";
+        }
+    }
+
+    return result;
+}
+
+void MetricsExporter::writeSnapshot( const String &path, Format format ) const
+{
+    MetricsSnapshot snapshot;
+    collect( snapshot );
+
+    if ( format == JSON_LINES )
+    {
+        unsigned long long timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch() ).count();
+        String line = toJson( snapshot, timestamp );
+
+        FILE *file = fopen( path.ascii(), "a" );
+        if ( !file )
+            throw CommonError( CommonError::OPEN_FAILED, path.ascii() );
+
+        bool written = ( fwrite( line.ascii(), 1, line.length(), file ) == line.length() );
+        written = ( fclose( file ) == 0 ) && written;
+
+        if ( !written )
+            throw CommonError( CommonError::WRITE_FAILED, path.ascii() );
+
+        return;
+    }
+
+    // Replace the file atomically, so that a scraper never sees a
+    // partial snapshot
+    String text = toPrometheus( snapshot );
+    String temporaryPath = path + ".tmp";
+
+    FILE *file = fopen( temporaryPath.ascii(), "w" );
+    if ( !file )
+        throw CommonError( CommonError::OPEN_FAILED, temporaryPath.ascii() );
+
+    bool written = ( fwrite( text.ascii(), 1, text.length(), file ) == text.length() );
+    written = ( fclose( file ) == 0 ) && written;
+
+    if ( !written || rename( temporaryPath.ascii(), path.ascii() ) != 0 )
+    {
+        remove( temporaryPath.ascii() );
+        throw CommonError( CommonError::WRITE_FAILED, path.ascii() );
+    }
+}
+
+void MetricsExporter::start( const String &path, Format format, unsigned periodMilli )
+{
+    stop();
+
+    std::unique_lock<std::mutex> lock( _mutex );
+    _path = path;
+    _format = format;
+    _periodMilli = ( periodMilli > 0 ) ? periodMilli : 1;
+    _running = true;
+
+    _thread = std::thread( &MetricsExporter::exportLoop, this );
+}
+
+void MetricsExporter::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+        if ( !_running )
+            return;
+
+        _running = false;
+    }
+
+    _wakeUp.notify_all();
+    _thread.join();
+
+    tryWriteSnapshot();
+}
+
+void MetricsExporter::exportLoop()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+
+    while ( _running )
+    {
+        if ( _wakeUp.wait_for( lock, std::chrono::milliseconds( _periodMilli ), [this]() { return !_running; } ) )
+            break;
+
+        // Collecting takes the lock itself
+        lock.unlock();
+        tryWriteSnapshot();
+        lock.lock();
+    }
+}
+
+void MetricsExporter::tryWriteSnapshot()
+{
+    bool failed = false;
+    try
+    {
+        writeSnapshot( _path, _format );
+    }
+    catch ( const CommonError & )
+    {
+        failed = true;
+    }
+
+    std::unique_lock<std::mutex> lock( _mutex );
+    if ( failed )
+        ++_numFailedWrites;
+    else
+        ++_numSnapshots;
+}
+
+unsigned long long MetricsExporter::getNumSnapshots() const
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    return _numSnapshots;
+}
+
+unsigned long long MetricsExporter::getNumFailedWrites() const
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    return _numFailedWrites;
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,182 @@
+/*********************                                                        */
+/*! \file MetricsExporter.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __MetricsExporter_h__
+#define __MetricsExporter_h__
+
+#include "List.h"
+#include "MString.h"
+#include "Map.h"
+#include "Vector.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+class Preprocessor;
+
+/*
+  A set of metric samples taken at one point in time. Every sample
+  belongs to a family, which has a type and a help text, and carries
+  a set of labels.
+*/
+class MetricsSnapshot
+{
+public:
+    enum Type {
+        COUNTER = 0,
+        GAUGE = 1,
+        SUMMARY = 2,
+    };
+
+    typedef List<std::pair<String, String> > Labels;
+
+    struct Sample
+    {
+        String _name;
+        Labels _labels;
+        double _value;
+    };
+
+    struct Family
+    {
+        String _name;
+        Type _type;
+        String _help;
+        List<Sample> _samples;
+    };
+
+    /*
+      Declare a family before adding samples to it. Redeclaring a
+      family is harmless. A sample may extend the family's name with a
+      suffix, as in Prometheus summaries (_sum, _count).
+    */
+    void declare( const String &family, Type type, const String &help );
+    void add( const String &family, double value, const Labels &labels = Labels() );
+    void add( const String &family, const String &name, double value, const Labels &labels );
+
+    const Vector<Family> &getFamilies() const;
+    void clear();
+
+    static Labels label( const String &name, const String &value );
+    static Labels label( const String &name, const String &value, const String &name2, const String &value2 );
+
+private:
+    Vector<Family> _families;
+    Map<String, unsigned> _familyIndex;
+};
+
+/*
+  Periodically writes snapshots of the solver's counters and timers to
+  a file, from a background thread, so that a batch service can scrape
+  them. Either every snapshot is appended as one JSON line, or the file
+  is atomically replaced by the latest snapshot in Prometheus text
+  format (for the node exporter's textfile collector).
+
+  Built in are the basis factorization operation timers and the
+  hardware performance counters. Preprocessing results are published
+  with setPreprocessorStatistics() once preprocessing is done, and any
+  other component can be added as a Source. Sources are read from the
+  background thread, so they must only read data that is safe to read
+  concurrently (atomics, or their own locking); none of the built-in
+  sources takes a lock on the solver's path.
+*/
+class MetricsExporter
+{
+public:
+    enum Format {
+        JSON_LINES = 0,
+        PROMETHEUS = 1,
+    };
+
+    class Source
+    {
+    public:
+        virtual ~Source() {}
+        virtual void collectMetrics( MetricsSnapshot &snapshot ) const = 0;
+    };
+
+    MetricsExporter();
+    ~MetricsExporter();
+
+    /*
+      Register a source, which must outlive the exporter or be removed
+      first.
+    */
+    void addSource( const Source *source );
+    void removeSource( const Source *source );
+
+    /*
+      Publish the results of the last preprocessing run.
+    */
+    void setPreprocessorStatistics( const Preprocessor &preprocessor );
+
+    /*
+      Collect a snapshot of all metrics.
+    */
+    void collect( MetricsSnapshot &snapshot ) const;
+
+    /*
+      Write a single snapshot now. Failures cause a CommonError.
+    */
+    void writeSnapshot( const String &path, Format format ) const;
+
+    static String toJson( const MetricsSnapshot &snapshot, unsigned long long timestampMilli );
+    static String toPrometheus( const MetricsSnapshot &snapshot );
+
+    /*
+      Start or stop writing a snapshot every periodMilli milliseconds.
+      Stopping writes a final snapshot. Write failures in the background
+      are counted, not thrown.
+    */
+    void start( const String &path, Format format, unsigned periodMilli );
+    void stop();
+
+    unsigned long long getNumSnapshots() const;
+    unsigned long long getNumFailedWrites() const;
+
+private:
+    mutable std::mutex _mutex;
+    List<const Source *> _sources;
+
+    /*
+      Preprocessing results, copied when published.
+    */
+    MetricsSnapshot _preprocessorMetrics;
+
+    std::thread _thread;
+    std::condition_variable _wakeUp;
+    bool _running;
+    String _path;
+    Format _format;
+    unsigned _periodMilli;
+
+    unsigned long long _numSnapshots;
+    unsigned long long _numFailedWrites;
+
+    void exportLoop();
+    void tryWriteSnapshot();
+
+    static void collectOperationTimers( MetricsSnapshot &snapshot );
+    static void collectPerfCounters( MetricsSnapshot &snapshot );
+};
+
+#endif // __MetricsExporter_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
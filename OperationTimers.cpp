@@ -0,0 +1,303 @@
+/*********************                                                        */
+/*! \file OperationTimers.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "OperationTimers.h"
+#include "Vector.h"
+
+#include <cstdio>
+#include <mutex>
+
+std::atomic<bool> OperationTimers::_enabled( false );
+
+namespace
+{
+    /*
+      The histograms of one thread. Only that thread records into them.
+    */
+    struct ThreadBuffers
+    {
+        ThreadBuffers()
+        {
+            reset();
+        }
+
+        void reset()
+        {
+            for ( unsigned i = 0; i < OperationTimers::NUM_OPERATIONS; ++i )
+            {
+                _latency[i].reset();
+                _inputNonZeros[i].reset();
+                _outputNonZeros[i].reset();
+                _inputSize[i].store( 0, std::memory_order_relaxed );
+                _outputSize[i].store( 0, std::memory_order_relaxed );
+            }
+        }
+
+        void mergeInto( OperationTimers::Operation operation, OperationTimers::Report &report ) const
+        {
+            report._latency.merge( _latency[operation] );
+            report._inputNonZeros.merge( _inputNonZeros[operation] );
+            report._outputNonZeros.merge( _outputNonZeros[operation] );
+            report._inputSize += _inputSize[operation].load( std::memory_order_relaxed );
+            report._outputSize += _outputSize[operation].load( std::memory_order_relaxed );
+        }
+
+        LogLinearHistogram _latency[OperationTimers::NUM_OPERATIONS];
+        LogLinearHistogram _inputNonZeros[OperationTimers::NUM_OPERATIONS];
+        LogLinearHistogram _outputNonZeros[OperationTimers::NUM_OPERATIONS];
+        std::atomic<unsigned long long> _inputSize[OperationTimers::NUM_OPERATIONS];
+        std::atomic<unsigned long long> _outputSize[OperationTimers::NUM_OPERATIONS];
+    };
+
+    /*
+      The buffers of the live threads, and the merged results of the
+      threads that have exited.
+    */
+    struct Registry
+    {
+        std::mutex _mutex;
+        Vector<ThreadBuffers *> _live;
+        OperationTimers::Report _retired[OperationTimers::NUM_OPERATIONS];
+
+        Registry()
+        {
+            for ( unsigned i = 0; i < OperationTimers::NUM_OPERATIONS; ++i )
+            {
+                _retired[i]._inputSize = 0;
+                _retired[i]._outputSize = 0;
+            }
+        }
+    };
+
+    Registry &getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    /*
+      Registers the thread's buffers on first use, and retires them
+      when the thread exits.
+    */
+    struct ThreadRegistration
+    {
+        ThreadRegistration()
+            : _buffers( new ThreadBuffers )
+        {
+            Registry &registry( getRegistry() );
+            std::unique_lock<std::mutex> lock( registry._mutex );
+            registry._live.append( _buffers );
+        }
+
+        ~ThreadRegistration()
+        {
+            Registry &registry( getRegistry() );
+            std::unique_lock<std::mutex> lock( registry._mutex );
+
+            for ( unsigned i = 0; i < OperationTimers::NUM_OPERATIONS; ++i )
+                _buffers->mergeInto( (OperationTimers::Operation)i, registry._retired[i] );
+
+            for ( unsigned i = 0; i < registry._live.size(); ++i )
+            {
+                if ( registry._live[i] == _buffers )
+                {
+                    registry._live[i] = registry._live.last();
+                    registry._live.popBack();
+                    break;
+                }
+            }
+
+            delete _buffers;
+        }
+
+        ThreadBuffers *_buffers;
+    };
+
+    thread_local ThreadRegistration threadRegistration;
+
+    std::once_flag calibrationFlag;
+    double nanosecondsPerTick = 1.0;
+
+    void calibrate()
+    {
+#if defined( __x86_64__ ) || defined( __i386__ )
+        // Compare the tick count to the monotonic clock over ~10ms
+        struct timespec startTime;
+        clock_gettime( CLOCK_MONOTONIC, &startTime );
+        unsigned long long startTicks = OperationTimers::now();
+
+        struct timespec endTime;
+        unsigned long long elapsed;
+        do
+        {
+            clock_gettime( CLOCK_MONOTONIC, &endTime );
+            elapsed = ( endTime.tv_sec - startTime.tv_sec ) * 1000000000ULL + endTime.tv_nsec - startTime.tv_nsec;
+        }
+        while ( elapsed < 10000000ULL );
+
+        unsigned long long ticks = OperationTimers::now() - startTicks;
+        if ( ticks > 0 )
+            nanosecondsPerTick = (double)elapsed / ticks;
+#endif
+    }
+}
+
+void OperationTimers::enable()
+{
+    _enabled = true;
+}
+
+void OperationTimers::disable()
+{
+    _enabled = false;
+}
+
+double OperationTimers::getNanosecondsPerTick()
+{
+    std::call_once( calibrationFlag, calibrate );
+    return nanosecondsPerTick;
+}
+
+unsigned OperationTimers::countNonZeros( const double *vector, unsigned size )
+{
+    unsigned result = 0;
+    for ( unsigned i = 0; i < size; ++i )
+        if ( vector[i] != 0.0 )
+            ++result;
+
+    return result;
+}
+
+void OperationTimers::record( Operation operation,
+                              unsigned long long ticks,
+                              unsigned inputNonZeros,
+                              unsigned inputSize,
+                              const double *output,
+                              unsigned outputSize )
+{
+    ThreadBuffers &buffers( *threadRegistration._buffers );
+
+    buffers._latency[operation].record( ticks );
+
+    if ( inputSize > 0 )
+    {
+        buffers._inputNonZeros[operation].record( inputNonZeros );
+        buffers._inputSize[operation].store( buffers._inputSize[operation].load( std::memory_order_relaxed ) + inputSize,
+                                             std::memory_order_relaxed );
+    }
+
+    if ( output )
+    {
+        buffers._outputNonZeros[operation].record( countNonZeros( output, outputSize ) );
+        buffers._outputSize[operation].store( buffers._outputSize[operation].load( std::memory_order_relaxed ) + outputSize,
+                                              std::memory_order_relaxed );
+    }
+}
+
+OperationTimers::Report OperationTimers::getReport( Operation operation )
+{
+    Registry &registry( getRegistry() );
+    std::unique_lock<std::mutex> lock( registry._mutex );
+
+    Report report( registry._retired[operation] );
+    for ( const auto &buffers : registry._live )
+        buffers->mergeInto( operation, report );
+
+    return report;
+}
+
+void OperationTimers::reset()
+{
+    Registry &registry( getRegistry() );
+    std::unique_lock<std::mutex> lock( registry._mutex );
+
+    for ( unsigned i = 0; i < NUM_OPERATIONS; ++i )
+    {
+        registry._retired[i]._latency.reset();
+        registry._retired[i]._inputNonZeros.reset();
+        registry._retired[i]._outputNonZeros.reset();
+        registry._retired[i]._inputSize = 0;
+        registry._retired[i]._outputSize = 0;
+    }
+
+    // Not synchronized with the owning threads, so counts recorded
+    // concurrently may survive the reset
+    for ( auto &buffers : registry._live )
+        buffers->reset();
+}
+
+void OperationTimers::print()
+{
+    double scale = getNanosecondsPerTick();
+
+    printf( "Basis factorization operations (latencies in nanoseconds):\n" );
+    for ( unsigned i = 0; i < NUM_OPERATIONS; ++i )
+    {
+        Report report = getReport( (Operation)i );
+        unsigned long long calls = report._latency.getCount();
+        if ( calls == 0 )
+            continue;
+
+        printf( "\t%s: %llu calls. p50: %.0f, p99: %.0f, max: %.0f, mean: %.0f\n",
+                getOperationName( (Operation)i ).ascii(),
+                calls,
+                report._latency.getPercentile( 50 ) * scale,
+                report._latency.getPercentile( 99 ) * scale,
+                report._latency.getMax() * scale,
+                report._latency.getMean() * scale );
+
+        if ( report._inputSize > 0 )
+            printf( "\t\tinput nonzeros p50: %llu, p99: %llu, density: %.3f\n",
+                    report._inputNonZeros.getPercentile( 50 ),
+                    report._inputNonZeros.getPercentile( 99 ),
+                    (double)report._inputNonZeros.getSum() / report._inputSize );
+
+        if ( report._outputSize > 0 )
+            printf( "\t\toutput nonzeros p50: %llu, p99: %llu, density: %.3f\n",
+                    report._outputNonZeros.getPercentile( 50 ),
+                    report._outputNonZeros.getPercentile( 99 ),
+                    (double)report._outputNonZeros.getSum() / report._outputSize );
+    }
+}
+
+String OperationTimers::getOperationName( Operation operation )
+{
+    switch ( operation )
+    {
+    case FORWARD_TRANSFORMATION:
+        return "forward-transformation";
+    case BACKWARD_TRANSFORMATION:
+        return "backward-transformation";
+    case PUSH_ETA:
+        return "push-eta";
+    case CONDENSE:
+        return "condense";
+    case FACTORIZE:
+        return "factorize";
+    case STORE:
+        return "store";
+    case RESTORE:
+        return "restore";
+    case NUM_OPERATIONS:
+        break;
+    }
+
+    return "unknown";
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
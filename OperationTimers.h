@@ -0,0 +1,183 @@
+/*********************                                                        */
+/*! \file OperationTimers.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __OperationTimers_h__
+#define __OperationTimers_h__
+
+#include "LogLinearHistogram.h"
+#include "MString.h"
+
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#endif
+
+/*
+  Per-call latency histograms for the basis factorization operations.
+
+  A Scope reads the time stamp counter on entry and exit (or a
+  monotonic clock, where there is none), and records the difference in
+  a histogram of the calling thread, together with the number of
+  nonzeros of the operation's input and output. Every thread records
+  into its own buffers, without locks; the buffers are merged on
+  demand, and the results of exited threads are kept.
+
+  Timing is off until enable() is called; a disabled scope costs a
+  single relaxed load.
+*/
+class OperationTimers
+{
+public:
+    enum Operation {
+        FORWARD_TRANSFORMATION = 0,
+        BACKWARD_TRANSFORMATION = 1,
+        PUSH_ETA = 2,
+        CONDENSE = 3,
+        FACTORIZE = 4,
+        STORE = 5,
+        RESTORE = 6,
+
+        NUM_OPERATIONS = 7,
+    };
+
+    /*
+      The merged histograms of one operation. Latencies are in ticks;
+      the sizes are the total number of entries of the inputs and
+      outputs, for computing densities.
+    */
+    struct Report
+    {
+        LogLinearHistogram _latency;
+        LogLinearHistogram _inputNonZeros;
+        LogLinearHistogram _outputNonZeros;
+        unsigned long long _inputSize;
+        unsigned long long _outputSize;
+    };
+
+    /*
+      Times the enclosing block, if timing is enabled. The input is
+      measured on entry, and the output, if set, on exit.
+    */
+    class Scope
+    {
+    public:
+        Scope( Operation operation, const double *input = NULL, unsigned inputSize = 0 )
+            : _operation( operation )
+            , _active( OperationTimers::enabled() )
+            , _inputNonZeros( 0 )
+            , _inputSize( 0 )
+            , _output( NULL )
+            , _outputSize( 0 )
+            , _start( 0 )
+        {
+            if ( !_active )
+                return;
+
+            if ( input )
+            {
+                _inputNonZeros = OperationTimers::countNonZeros( input, inputSize );
+                _inputSize = inputSize;
+            }
+
+            _start = OperationTimers::now();
+        }
+
+        void setOutput( const double *output, unsigned outputSize )
+        {
+            _output = output;
+            _outputSize = outputSize;
+        }
+
+        ~Scope()
+        {
+            if ( _active )
+                OperationTimers::record( _operation,
+                                         OperationTimers::now() - _start,
+                                         _inputNonZeros,
+                                         _inputSize,
+                                         _output,
+                                         _outputSize );
+        }
+
+    private:
+        Operation _operation;
+        bool _active;
+        unsigned _inputNonZeros;
+        unsigned _inputSize;
+        const double *_output;
+        unsigned _outputSize;
+        unsigned long long _start;
+    };
+
+    static void enable();
+    static void disable();
+
+    static bool enabled()
+    {
+        return _enabled.load( std::memory_order_relaxed );
+    }
+
+    /*
+      The current tick count, and the length of a tick.
+    */
+    static unsigned long long now()
+    {
+#if defined( __x86_64__ ) || defined( __i386__ )
+        return __rdtsc();
+#else
+        struct timespec time;
+        clock_gettime( CLOCK_MONOTONIC, &time );
+        return time.tv_sec * 1000000000ULL + time.tv_nsec;
+#endif
+    }
+
+    static double getNanosecondsPerTick();
+
+    /*
+      Merge the buffers of all threads.
+    */
+    static Report getReport( Operation operation );
+    static void reset();
+
+    /*
+      Print p50, p99 and maximal latency, and the mean input and output
+      densities, of every operation that ran.
+    */
+    static void print();
+
+    static String getOperationName( Operation operation );
+
+    static unsigned countNonZeros( const double *vector, unsigned size );
+
+private:
+    static std::atomic<bool> _enabled;
+
+    static void record( Operation operation,
+                        unsigned long long ticks,
+                        unsigned inputNonZeros,
+                        unsigned inputSize,
+                        const double *output,
+                        unsigned outputSize );
+};
+
+#endif // __OperationTimers_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
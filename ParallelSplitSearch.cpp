@@ -0,0 +1,375 @@
+/*********************                                                        */
+/*! \file ParallelSplitSearch.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "BasisFactorization.h"
+#include "BoundStore.h"
+#include "Debug.h"
+#include "FloatUtils.h"
+#include "InputQuery.h"
+#include "ParallelSplitSearch.h"
+#include "ReluplexError.h"
+
+#include <thread>
+#include <vector>
+
+ParallelSplitSearch::ParallelSplitSearch( const InputQuery &query, unsigned m, const Vector<Solver *> &solvers )
+    : _m( m )
+    , _solvers( solvers )
+    , _sharedBounds( NULL )
+    , _openNodes( 0 )
+    , _stop( false )
+    , _satisfiable( false )
+    , _aborted( false )
+    , _satisfyingWorker( 0 )
+{
+    ASSERT( !_solvers.empty() );
+
+    for ( unsigned i = 0; i < _solvers.size(); ++i )
+    {
+        Worker *worker = new Worker;
+        if ( !worker )
+            throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "ParallelSplitSearch::worker" );
+
+        worker->_bounds = new BoundStore( query );
+        worker->_factorization = new BasisFactorization( _m );
+        worker->_currentDepth = 0;
+        worker->_numNodes = 0;
+        worker->_numSteals = 0;
+        worker->_maxDepth = 0;
+
+        _workers.append( worker );
+    }
+}
+
+ParallelSplitSearch::~ParallelSplitSearch()
+{
+    freeIfNeeded();
+}
+
+void ParallelSplitSearch::freeIfNeeded()
+{
+    clearNodes();
+
+    for ( auto &worker : _workers )
+    {
+        delete worker->_bounds;
+        delete worker->_factorization;
+        delete worker;
+    }
+    _workers.clear();
+}
+
+void ParallelSplitSearch::clearNodes()
+{
+    for ( auto &worker : _workers )
+    {
+        for ( auto &node : worker->_nodes )
+            delete node;
+        worker->_nodes.clear();
+    }
+}
+
+void ParallelSplitSearch::setSharedBounds( SharedBoundDatabase *sharedBounds )
+{
+    _sharedBounds = sharedBounds;
+}
+
+ParallelSplitSearch::Result ParallelSplitSearch::run()
+{
+    clearNodes();
+
+    _stop = false;
+    _satisfiable = false;
+    _aborted = false;
+    _error = nullptr;
+
+    for ( auto &worker : _workers )
+    {
+        worker->_bounds->popToLevel( 0 );
+        if ( _sharedBounds )
+            _sharedBounds->subscribe( worker->_subscriber );
+    }
+
+    // The root: no splits, and no checkpoint
+    SearchNode *root = new SearchNode;
+    root->_depth = 0;
+    _workers[0]->_nodes.push_back( root );
+    _openNodes = 1;
+
+    std::vector<std::thread> threads;
+    for ( unsigned i = 0; i < _workers.size(); ++i )
+        threads.push_back( std::thread( &ParallelSplitSearch::workerLoop, this, i ) );
+
+    for ( auto &thread : threads )
+        thread.join();
+
+    // Nodes left over after a stop
+    clearNodes();
+
+    if ( _error )
+    {
+        std::exception_ptr error = _error;
+        _error = nullptr;
+        std::rethrow_exception( error );
+    }
+
+    if ( _satisfiable )
+        return SAT;
+
+    if ( _aborted )
+        return UNKNOWN;
+
+    if ( _sharedBounds && _sharedBounds->isInfeasible() )
+        return UNSAT;
+
+    // Stopped before the tree was exhausted
+    if ( _openNodes > 0 )
+        return UNKNOWN;
+
+    return UNSAT;
+}
+
+void ParallelSplitSearch::workerLoop( unsigned worker )
+{
+    while ( !_stop )
+    {
+        SearchNode *node = popLocal( worker );
+        if ( !node )
+            node = steal( worker );
+
+        if ( !node )
+        {
+            if ( _openNodes == 0 )
+                return;
+
+            std::this_thread::yield();
+            continue;
+        }
+
+        try
+        {
+            processNode( worker, node );
+        }
+        catch ( ... )
+        {
+            std::unique_lock<std::mutex> lock( _errorMutex );
+            if ( !_error )
+                _error = std::current_exception();
+
+            _aborted = true;
+            _stop = true;
+        }
+
+        delete node;
+
+        // Children were counted before their parent is retired, so zero
+        // means the whole tree is done
+        if ( _openNodes.fetch_sub( 1 ) == 1 )
+            return;
+    }
+}
+
+ParallelSplitSearch::SearchNode *ParallelSplitSearch::popLocal( unsigned worker )
+{
+    Worker &own = *_workers[worker];
+    std::unique_lock<std::mutex> lock( own._mutex );
+
+    if ( own._nodes.empty() )
+        return NULL;
+
+    SearchNode *node = own._nodes.back();
+    own._nodes.pop_back();
+    return node;
+}
+
+ParallelSplitSearch::SearchNode *ParallelSplitSearch::steal( unsigned thief )
+{
+    unsigned numWorkers = _workers.size();
+
+    for ( unsigned i = 1; i < numWorkers; ++i )
+    {
+        Worker &victim = *_workers[( thief + i ) % numWorkers];
+        std::unique_lock<std::mutex> lock( victim._mutex, std::try_to_lock );
+
+        if ( !lock.owns_lock() || victim._nodes.empty() )
+            continue;
+
+        SearchNode *node = victim._nodes.front();
+        victim._nodes.pop_front();
+        ++_workers[thief]->_numSteals;
+        return node;
+    }
+
+    return NULL;
+}
+
+void ParallelSplitSearch::processNode( unsigned worker, SearchNode *node )
+{
+    Worker &own = *_workers[worker];
+    BoundStore &bounds = *own._bounds;
+
+    own._currentDepth = node->_depth;
+    ++own._numNodes;
+    if ( node->_depth > own._maxDepth )
+        own._maxDepth = node->_depth;
+
+    // Level 0 holds the root bounds, plus any globally valid bounds
+    // imported from the other workers
+    bounds.popToLevel( 0 );
+    if ( _sharedBounds )
+    {
+        _sharedBounds->importBounds( own._subscriber, bounds );
+        if ( _sharedBounds->isInfeasible() )
+        {
+            _stop = true;
+            return;
+        }
+    }
+
+    bounds.pushLevel();
+    for ( const auto &split : node->_splits )
+    {
+        if ( split._type == Tightening::LB )
+        {
+            if ( FloatUtils::gt( split._value, bounds.getLowerBound( split._variable ) ) )
+                bounds.setLowerBound( split._variable, split._value );
+        }
+        else
+        {
+            if ( FloatUtils::lt( split._value, bounds.getUpperBound( split._variable ) ) )
+                bounds.setUpperBound( split._variable, split._value );
+        }
+    }
+
+    if ( node->_checkpoint )
+        own._factorization->restoreFactorization( node->_checkpoint.get() );
+
+    List<List<Tightening> > caseSplits;
+    Solver::Outcome outcome = _solvers[worker]->solve( worker, bounds, *own._factorization, caseSplits );
+
+    switch ( outcome )
+    {
+    case Solver::NODE_UNSAT:
+        break;
+
+    case Solver::NODE_SAT:
+        if ( !_satisfiable.exchange( true ) )
+            _satisfyingWorker = worker;
+        _stop = true;
+        break;
+
+    case Solver::NODE_ABORTED:
+        _aborted = true;
+        _stop = true;
+        break;
+
+    case Solver::NODE_SPLIT:
+    {
+        // A split without cases would retire the node as if it were
+        // refuted, so it is treated as a failure of the solver
+        if ( caseSplits.empty() )
+        {
+            _aborted = true;
+            _stop = true;
+            break;
+        }
+
+        std::shared_ptr<BasisFactorization> checkpoint( new BasisFactorization( _m ) );
+        own._factorization->storeFactorization( checkpoint.get() );
+
+        _openNodes += caseSplits.size();
+
+        // Push in reverse, so that the first case is solved next
+        std::unique_lock<std::mutex> lock( own._mutex );
+        for ( auto it = caseSplits.rbegin(); it != caseSplits.rend(); ++it )
+        {
+            SearchNode *child = new SearchNode;
+            child->_depth = node->_depth + 1;
+            child->_splits = node->_splits;
+            for ( const auto &tightening : *it )
+                child->_splits.append( tightening );
+            child->_checkpoint = checkpoint;
+
+            own._nodes.push_back( child );
+        }
+        break;
+    }
+    }
+}
+
+void ParallelSplitSearch::requestStop()
+{
+    _stop = true;
+}
+
+bool ParallelSplitSearch::stopRequested() const
+{
+    return _stop;
+}
+
+unsigned ParallelSplitSearch::getSatisfyingWorker() const
+{
+    return _satisfyingWorker;
+}
+
+const BoundStore &ParallelSplitSearch::getBounds( unsigned worker ) const
+{
+    return *_workers[worker]->_bounds;
+}
+
+unsigned ParallelSplitSearch::getCurrentDepth( unsigned worker ) const
+{
+    return _workers[worker]->_currentDepth;
+}
+
+unsigned ParallelSplitSearch::getNumberOfWorkers() const
+{
+    return _workers.size();
+}
+
+unsigned long long ParallelSplitSearch::getNumNodes() const
+{
+    unsigned long long result = 0;
+    for ( const auto &worker : _workers )
+        result += worker->_numNodes;
+    return result;
+}
+
+unsigned long long ParallelSplitSearch::getNumNodes( unsigned worker ) const
+{
+    return _workers[worker]->_numNodes;
+}
+
+unsigned long long ParallelSplitSearch::getNumSteals() const
+{
+    unsigned long long result = 0;
+    for ( const auto &worker : _workers )
+        result += worker->_numSteals;
+    return result;
+}
+
+unsigned ParallelSplitSearch::getMaxDepth() const
+{
+    unsigned result = 0;
+    for ( const auto &worker : _workers )
+        if ( worker->_maxDepth > result )
+            result = worker->_maxDepth;
+    return result;
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
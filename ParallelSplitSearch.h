@@ -0,0 +1,194 @@
+/*********************                                                        */
+/*! \file ParallelSplitSearch.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __ParallelSplitSearch_h__
+#define __ParallelSplitSearch_h__
+
+#include "List.h"
+#include "SharedBoundDatabase.h"
+#include "Tightening.h"
+#include "Vector.h"
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+class BasisFactorization;
+class BoundStore;
+class InputQuery;
+
+/*
+  A parallel search over case splits (e.g. ReLU phases). Each open node
+  of the search tree is a subproblem, described by the case splits that
+  lead to it from the root.
+
+  Every worker thread owns a bound store and a basis factorization, and
+  a deque of open nodes. A worker takes its own nodes from the deep end
+  of its deque, depth first, and an idle worker steals from the shallow
+  end of another worker's deque, so that stolen nodes carry as much work
+  as possible. When a node is split, the worker stores its
+  factorization as a checkpoint that seeds the children, wherever they
+  end up being solved.
+
+  The solving itself is delegated to a Solver, one per worker. The
+  search ends when a node is satisfiable, when all nodes were refuted,
+  or when it is stopped.
+*/
+class ParallelSplitSearch
+{
+public:
+    enum Result {
+        UNSAT = 0,
+        SAT = 1,
+        UNKNOWN = 2,
+    };
+
+    /*
+      Solves one node. The bounds hold the query's bounds restricted by
+      the node's case splits, and the factorization is seeded from the
+      parent's checkpoint (or is fresh, at the root). To split, the
+      solver fills in one list of tightenings per case and returns
+      SPLIT; a split with no cases aborts the search, which then
+      returns UNKNOWN. Long-running solvers should poll stopRequested().
+    */
+    class Solver
+    {
+    public:
+        enum Outcome {
+            NODE_UNSAT = 0,
+            NODE_SAT = 1,
+            NODE_SPLIT = 2,
+            NODE_ABORTED = 3,
+        };
+
+        virtual ~Solver() {}
+        virtual Outcome solve( unsigned worker,
+                               BoundStore &bounds,
+                               BasisFactorization &factorization,
+                               List<List<Tightening> > &caseSplits ) = 0;
+    };
+
+    /*
+      The number of workers is the number of solvers. m is the
+      dimension of the basis.
+    */
+    ParallelSplitSearch( const InputQuery &query, unsigned m, const Vector<Solver *> &solvers );
+    ~ParallelSplitSearch();
+
+    /*
+      Free any allocated memory.
+    */
+    void freeIfNeeded();
+
+    /*
+      Optionally share globally valid bounds between the workers. Each
+      worker imports the improvements before it starts a node.
+    */
+    void setSharedBounds( SharedBoundDatabase *sharedBounds );
+
+    /*
+      Run the search to completion, and block until all workers are
+      done. If a solver throws, the search is stopped and the first
+      exception is rethrown once the workers are done.
+    */
+    Result run();
+
+    /*
+      Cooperative cancellation, safe to call from any thread.
+    */
+    void requestStop();
+    bool stopRequested() const;
+
+    /*
+      The worker that found a satisfying assignment, if any. Its solver
+      and bound store still describe the satisfiable node.
+    */
+    unsigned getSatisfyingWorker() const;
+    const BoundStore &getBounds( unsigned worker ) const;
+
+    /*
+      The depth of the node that a worker is solving, for use by its
+      solver.
+    */
+    unsigned getCurrentDepth( unsigned worker ) const;
+
+    /*
+      Statistics
+    */
+    unsigned getNumberOfWorkers() const;
+    unsigned long long getNumNodes() const;
+    unsigned long long getNumNodes( unsigned worker ) const;
+    unsigned long long getNumSteals() const;
+    unsigned getMaxDepth() const;
+
+private:
+    struct SearchNode
+    {
+        unsigned _depth;
+        List<Tightening> _splits;
+        std::shared_ptr<BasisFactorization> _checkpoint;
+    };
+
+    struct Worker
+    {
+        std::mutex _mutex;
+        std::deque<SearchNode *> _nodes;
+
+        BoundStore *_bounds;
+        BasisFactorization *_factorization;
+        SharedBoundDatabase::Subscriber _subscriber;
+
+        unsigned _currentDepth;
+        unsigned long long _numNodes;
+        unsigned long long _numSteals;
+        unsigned _maxDepth;
+    };
+
+    unsigned _m;
+    Vector<Solver *> _solvers;
+    Vector<Worker *> _workers;
+    SharedBoundDatabase *_sharedBounds;
+
+    /*
+      Nodes that were created but not finished yet. The search is over
+      when this drops to zero.
+    */
+    std::atomic<unsigned long long> _openNodes;
+    std::atomic<bool> _stop;
+    std::atomic<bool> _satisfiable;
+    std::atomic<bool> _aborted;
+    std::atomic<unsigned> _satisfyingWorker;
+
+    /*
+      The first exception thrown while processing a node.
+    */
+    std::mutex _errorMutex;
+    std::exception_ptr _error;
+
+    void workerLoop( unsigned worker );
+    SearchNode *popLocal( unsigned worker );
+    SearchNode *steal( unsigned thief );
+    void processNode( unsigned worker, SearchNode *node );
+    void clearNodes();
+};
+
+#endif // __ParallelSplitSearch_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
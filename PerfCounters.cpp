@@ -0,0 +1,292 @@
+/*********************                                                        */
+/*! \file PerfCounters.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "PerfCounters.h"
+
+#include <cstdio>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+std::atomic<bool> PerfCounters::_enabled( false );
+
+namespace
+{
+    std::atomic<unsigned> samplingPeriod( 1 );
+    std::atomic<bool> anyCountersAvailable( false );
+
+    std::atomic<unsigned long long> totalCalls[PerfCounters::NUM_CATEGORIES];
+    std::atomic<unsigned long long> totalSampledCalls[PerfCounters::NUM_CATEGORIES];
+    std::atomic<unsigned long long> totalEvents[PerfCounters::NUM_CATEGORIES][PerfCounters::NUM_EVENTS];
+
+    const unsigned long long EVENT_CONFIGS[PerfCounters::NUM_EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    /*
+      The counters of one thread: a group led by the cycle counter, so
+      that all events are scheduled together. Closed when the thread
+      exits.
+    */
+    struct ThreadCounters
+    {
+        ThreadCounters()
+            : _opened( false )
+            , _available( false )
+        {
+            for ( unsigned i = 0; i < PerfCounters::NUM_EVENTS; ++i )
+                _fds[i] = -1;
+
+            for ( unsigned i = 0; i < PerfCounters::NUM_CATEGORIES; ++i )
+            {
+                _pendingCalls[i] = 0;
+                _untilSample[i] = 0;
+            }
+        }
+
+        ~ThreadCounters()
+        {
+            // Calls not yet added to the totals would be lost with the
+            // thread
+            for ( unsigned i = 0; i < PerfCounters::NUM_CATEGORIES; ++i )
+                totalCalls[i] += _pendingCalls[i];
+
+            for ( unsigned i = 0; i < PerfCounters::NUM_EVENTS; ++i )
+                if ( _fds[i] != -1 )
+                    close( _fds[i] );
+        }
+
+        void open()
+        {
+            _opened = true;
+
+            for ( unsigned i = 0; i < PerfCounters::NUM_EVENTS; ++i )
+            {
+                struct perf_event_attr attributes;
+                memset( &attributes, 0, sizeof(attributes) );
+                attributes.size = sizeof(attributes);
+                attributes.type = PERF_TYPE_HARDWARE;
+                attributes.config = EVENT_CONFIGS[i];
+                attributes.disabled = ( i == 0 ) ? 1 : 0;
+                attributes.exclude_kernel = 1;
+                attributes.exclude_hv = 1;
+                attributes.read_format = PERF_FORMAT_GROUP |
+                    PERF_FORMAT_TOTAL_TIME_ENABLED |
+                    PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                // This thread, any cpu
+                int groupFd = ( i == 0 ) ? -1 : _fds[0];
+                _fds[i] = syscall( __NR_perf_event_open, &attributes, 0, -1, groupFd, 0 );
+
+                if ( _fds[i] == -1 )
+                    return;
+            }
+
+            if ( ioctl( _fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP ) == -1 )
+                return;
+
+            _available = true;
+            anyCountersAvailable = true;
+        }
+
+        bool read( PerfCounters::Sample &sample ) const
+        {
+            // nr, time enabled, time running, one value per event
+            unsigned long long buffer[3 + PerfCounters::NUM_EVENTS];
+            ssize_t size = ::read( _fds[0], buffer, sizeof(buffer) );
+            if ( size != sizeof(buffer) || buffer[0] != PerfCounters::NUM_EVENTS )
+                return false;
+
+            sample._timeEnabled = buffer[1];
+            sample._timeRunning = buffer[2];
+            for ( unsigned i = 0; i < PerfCounters::NUM_EVENTS; ++i )
+                sample._values[i] = buffer[3 + i];
+
+            return true;
+        }
+
+        int _fds[PerfCounters::NUM_EVENTS];
+        bool _opened;
+        bool _available;
+
+        /*
+          Calls not yet added to the totals, and the number of calls
+          until the next sampled one.
+        */
+        unsigned long long _pendingCalls[PerfCounters::NUM_CATEGORIES];
+        unsigned _untilSample[PerfCounters::NUM_CATEGORIES];
+    };
+
+    thread_local ThreadCounters threadCounters;
+}
+
+void PerfCounters::enable( unsigned period )
+{
+    samplingPeriod = ( period > 0 ) ? period : 1;
+    _enabled = true;
+}
+
+void PerfCounters::disable()
+{
+    _enabled = false;
+}
+
+bool PerfCounters::countersAvailable()
+{
+    return anyCountersAvailable;
+}
+
+bool PerfCounters::begin( Category category, Sample &start )
+{
+    ThreadCounters &counters( threadCounters );
+
+    ++counters._pendingCalls[category];
+    if ( counters._untilSample[category] > 0 )
+    {
+        --counters._untilSample[category];
+        return false;
+    }
+
+    counters._untilSample[category] = samplingPeriod.load( std::memory_order_relaxed ) - 1;
+
+    totalCalls[category] += counters._pendingCalls[category];
+    counters._pendingCalls[category] = 0;
+    ++totalSampledCalls[category];
+
+    if ( !counters._opened )
+        counters.open();
+
+    if ( !counters._available )
+        return false;
+
+    return counters.read( start );
+}
+
+void PerfCounters::end( Category category, const Sample &start )
+{
+    Sample finish;
+    if ( !threadCounters.read( finish ) )
+        return;
+
+    // Scale up if the group was multiplexed out for part of the call
+    unsigned long long enabled = finish._timeEnabled - start._timeEnabled;
+    unsigned long long running = finish._timeRunning - start._timeRunning;
+    if ( running == 0 )
+        return;
+
+    double scale = (double)enabled / running;
+    for ( unsigned i = 0; i < NUM_EVENTS; ++i )
+        totalEvents[category][i] += (unsigned long long)( ( finish._values[i] - start._values[i] ) * scale );
+}
+
+PerfCounters::Totals PerfCounters::getTotals( Category category )
+{
+    Totals totals;
+    totals._calls = totalCalls[category] + threadCounters._pendingCalls[category];
+    totals._sampledCalls = totalSampledCalls[category];
+    for ( unsigned i = 0; i < NUM_EVENTS; ++i )
+        totals._events[i] = totalEvents[category][i];
+
+    return totals;
+}
+
+void PerfCounters::reset()
+{
+    for ( unsigned i = 0; i < NUM_CATEGORIES; ++i )
+    {
+        totalCalls[i] = 0;
+        totalSampledCalls[i] = 0;
+        for ( unsigned j = 0; j < NUM_EVENTS; ++j )
+            totalEvents[i][j] = 0;
+    }
+}
+
+void PerfCounters::print()
+{
+    printf( "Performance counters (%s):\n",
+            countersAvailable() ? "sampled" : "unavailable, calls only" );
+
+    for ( unsigned i = 0; i < NUM_CATEGORIES; ++i )
+    {
+        Totals totals = getTotals( (Category)i );
+        if ( totals._calls == 0 )
+            continue;
+
+        printf( "\t%s: %llu calls (%llu sampled)\n",
+                getCategoryName( (Category)i ).ascii(),
+                totals._calls,
+                totals._sampledCalls );
+
+        if ( !countersAvailable() || totals._sampledCalls == 0 )
+            continue;
+
+        for ( unsigned j = 0; j < NUM_EVENTS; ++j )
+            printf( "\t\t%s: %llu (%.1f per sampled call)\n",
+                    getEventName( (Event)j ).ascii(),
+                    totals._events[j],
+                    (double)totals._events[j] / totals._sampledCalls );
+
+        if ( totals._events[CYCLES] > 0 )
+            printf( "\t\tIPC: %.2f\n", (double)totals._events[INSTRUCTIONS] / totals._events[CYCLES] );
+    }
+}
+
+String PerfCounters::getCategoryName( Category category )
+{
+    switch ( category )
+    {
+    case FACTORIZE:
+        return "factorize";
+    case FORWARD_TRANSFORMATION:
+        return "forward-transformation";
+    case BACKWARD_TRANSFORMATION:
+        return "backward-transformation";
+    case PROCESS_EQUATIONS:
+        return "process-equations";
+    case NUM_CATEGORIES:
+        break;
+    }
+
+    return "unknown";
+}
+
+String PerfCounters::getEventName( Event event )
+{
+    switch ( event )
+    {
+    case CYCLES:
+        return "cycles";
+    case INSTRUCTIONS:
+        return "instructions";
+    case CACHE_MISSES:
+        return "cache-misses";
+    case BRANCH_MISSES:
+        return "branch-misses";
+    case NUM_EVENTS:
+        break;
+    }
+
+    return "unknown";
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
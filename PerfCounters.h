@@ -0,0 +1,151 @@
+/*********************                                                        */
+/*! \file PerfCounters.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __PerfCounters_h__
+#define __PerfCounters_h__
+
+#include "MString.h"
+
+#include <atomic>
+
+/*
+  Hardware performance counters (cycles, instructions, cache misses and
+  branch misses) collected per category of hot-path calls, using Linux
+  perf_event_open.
+
+  Instrumented functions open a PERF_COUNTER_SCOPE. The macro expands to
+  nothing unless the code is built with MARABOU_PERF_COUNTERS, and even
+  then counting is off until enable() is called; a disabled scope costs
+  a single relaxed load. When enabled, only one call in every sampling
+  period (per thread and category) reads the counters, which keeps the
+  overhead low enough for production runs. The totals are aggregated
+  over all threads.
+
+  If the kernel refuses to open the counters (e.g. because of
+  perf_event_paranoid), calls are still counted but no events are.
+*/
+class PerfCounters
+{
+public:
+    enum Category {
+        FACTORIZE = 0,
+        FORWARD_TRANSFORMATION = 1,
+        BACKWARD_TRANSFORMATION = 2,
+        PROCESS_EQUATIONS = 3,
+
+        NUM_CATEGORIES = 4,
+    };
+
+    enum Event {
+        CYCLES = 0,
+        INSTRUCTIONS = 1,
+        CACHE_MISSES = 2,
+        BRANCH_MISSES = 3,
+
+        NUM_EVENTS = 4,
+    };
+
+    /*
+      The counts of one category. Calls are all instrumented calls;
+      the events only cover the sampled ones.
+    */
+    struct Totals
+    {
+        unsigned long long _calls;
+        unsigned long long _sampledCalls;
+        unsigned long long _events[NUM_EVENTS];
+    };
+
+    /*
+      A reading of the calling thread's counters.
+    */
+    struct Sample
+    {
+        unsigned long long _values[NUM_EVENTS];
+        unsigned long long _timeEnabled;
+        unsigned long long _timeRunning;
+    };
+
+    /*
+      Counts the enclosing block, if counting is enabled.
+    */
+    class Scope
+    {
+    public:
+        Scope( Category category )
+            : _category( category )
+            , _sampled( false )
+        {
+            if ( PerfCounters::enabled() )
+                _sampled = PerfCounters::begin( category, _start );
+        }
+
+        ~Scope()
+        {
+            if ( _sampled )
+                PerfCounters::end( _category, _start );
+        }
+
+    private:
+        Category _category;
+        bool _sampled;
+        Sample _start;
+    };
+
+    /*
+      Start counting, reading the counters on one call in every
+      samplingPeriod, or stop counting.
+    */
+    static void enable( unsigned samplingPeriod = 1 );
+    static void disable();
+
+    static bool enabled()
+    {
+        return _enabled.load( std::memory_order_relaxed );
+    }
+
+    /*
+      Whether the kernel provided the counters to any thread.
+    */
+    static bool countersAvailable();
+
+    static Totals getTotals( Category category );
+    static void reset();
+    static void print();
+
+    static String getCategoryName( Category category );
+    static String getEventName( Event event );
+
+private:
+    static std::atomic<bool> _enabled;
+
+    static bool begin( Category category, Sample &start );
+    static void end( Category category, const Sample &start );
+};
+
+#ifdef MARABOU_PERF_COUNTERS
+#define PERF_COUNTER_SCOPE_NAME2( line ) __perfCounterScope##line
+#define PERF_COUNTER_SCOPE_NAME( line ) PERF_COUNTER_SCOPE_NAME2( line )
+#define PERF_COUNTER_SCOPE( category ) PerfCounters::Scope PERF_COUNTER_SCOPE_NAME( __LINE__ )( category )
+#else
+#define PERF_COUNTER_SCOPE( category )
+#endif
+
+#endif // __PerfCounters_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,370 @@
+/*********************                                                        */
+/*! \file PortfolioRunner.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "BasisFactorization.h"
+#include "CommonError.h"
+#include "Debug.h"
+#include "GlobalConfiguration.h"
+#include "InfeasibleQueryException.h"
+#include "PortfolioRunner.h"
+#include "TimeUtils.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::string trim( const std::string &text )
+    {
+        size_t first = text.find_first_not_of( " \t\r\n" );
+        if ( first == std::string::npos )
+            return "";
+
+        size_t last = text.find_last_not_of( " \t\r\n" );
+        return text.substr( first, last - first + 1 );
+    }
+
+    bool parseUnsigned( const std::string &text, unsigned long long &value )
+    {
+        if ( text.empty() )
+            return false;
+
+        char *end;
+        errno = 0;
+        value = strtoull( text.c_str(), &end, 10 );
+        return errno == 0 && *end == '\0' && text[0] != '-';
+    }
+
+    bool parseBool( const std::string &text, bool &value )
+    {
+        if ( text == "true" || text == "1" )
+            value = true;
+        else if ( text == "false" || text == "0" )
+            value = false;
+        else
+            return false;
+
+        return true;
+    }
+
+    // name[:maxIterations[:maxTimeMicro]]
+    bool parsePass( const std::string &text, Preprocessor::PassConfiguration &pass )
+    {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        while ( true )
+        {
+            size_t colon = text.find( ':', start );
+            fields.push_back( text.substr( start, colon == std::string::npos ? std::string::npos : colon - start ) );
+            if ( colon == std::string::npos )
+                break;
+            start = colon + 1;
+        }
+
+        if ( fields.size() > 3 )
+            return false;
+
+        bool found = false;
+        for ( unsigned type = Preprocessor::PROPAGATION; type <= Preprocessor::VARIABLE_ELIMINATION; ++type )
+        {
+            if ( fields[0] == Preprocessor::getPassName( (Preprocessor::PassType)type ).ascii() )
+            {
+                pass._type = (Preprocessor::PassType)type;
+                found = true;
+            }
+        }
+
+        if ( !found )
+            return false;
+
+        unsigned long long value;
+        if ( fields.size() > 1 )
+        {
+            if ( !parseUnsigned( fields[1], value ) )
+                return false;
+            pass._maxIterations = value;
+        }
+
+        if ( fields.size() > 2 )
+        {
+            if ( !parseUnsigned( fields[2], value ) )
+                return false;
+            pass._maxTimeMicro = value;
+        }
+
+        return true;
+    }
+}
+
+PortfolioRunner::Configuration::Configuration()
+    : _attemptVariableElimination( true )
+    , _refactorizationThreshold( GlobalConfiguration::REFACTORIZATION_THRESHOLD )
+{
+}
+
+PortfolioRunner::PortfolioRunner( const InputQuery &query, SolverFactory &factory )
+    : _query( query )
+    , _factory( factory )
+    , _cancel( false )
+    , _winner( NO_WINNER )
+{
+}
+
+PortfolioRunner::~PortfolioRunner()
+{
+    freeIfNeeded();
+}
+
+void PortfolioRunner::freeIfNeeded()
+{
+    for ( auto &instance : _instances )
+    {
+        if ( instance._solver )
+        {
+            delete instance._solver;
+            instance._solver = NULL;
+        }
+    }
+
+    _instances.clear();
+}
+
+void PortfolioRunner::addConfiguration( const Configuration &configuration )
+{
+    _configurations.append( configuration );
+}
+
+void PortfolioRunner::loadConfigurations( const String &path )
+{
+    for ( const auto &configuration : parseConfigurations( path ) )
+        addConfiguration( configuration );
+}
+
+List<PortfolioRunner::Configuration> PortfolioRunner::parseConfigurations( const String &path )
+{
+    FILE *file = fopen( path.ascii(), "r" );
+    if ( !file )
+        throw CommonError( CommonError::OPEN_FAILED, path.ascii() );
+
+    List<Configuration> configurations;
+    bool valid = true;
+
+    char *buffer = NULL;
+    size_t bufferSize = 0;
+    while ( valid && getline( &buffer, &bufferSize, file ) != -1 )
+    {
+        std::string line = buffer;
+        size_t comment = line.find( '#' );
+        if ( comment != std::string::npos )
+            line = line.substr( 0, comment );
+        line = trim( line );
+
+        if ( line.empty() )
+            continue;
+
+        if ( line[0] == '[' )
+        {
+            if ( line[line.size() - 1] != ']' )
+            {
+                valid = false;
+                break;
+            }
+
+            Configuration configuration;
+            configuration._name = trim( line.substr( 1, line.size() - 2 ) ).c_str();
+            configurations.append( configuration );
+            continue;
+        }
+
+        // Settings must belong to a section
+        size_t equals = line.find( '=' );
+        if ( configurations.empty() || equals == std::string::npos )
+        {
+            valid = false;
+            break;
+        }
+
+        Configuration &configuration = configurations.back();
+        std::string key = trim( line.substr( 0, equals ) );
+        std::string value = trim( line.substr( equals + 1 ) );
+
+        if ( key == "attemptVariableElimination" )
+        {
+            valid = parseBool( value, configuration._attemptVariableElimination );
+        }
+        else if ( key == "refactorizationThreshold" )
+        {
+            unsigned long long threshold;
+            valid = parseUnsigned( value, threshold ) && ( threshold >= 1 ) && ( threshold <= UINT_MAX );
+            configuration._refactorizationThreshold = threshold;
+        }
+        else if ( key == "passes" )
+        {
+            configuration._passes.clear();
+
+            size_t start = 0;
+            while ( valid && start < value.size() )
+            {
+                size_t end = value.find_first_of( " \t,", start );
+                if ( end == std::string::npos )
+                    end = value.size();
+
+                if ( end > start )
+                {
+                    Preprocessor::PassConfiguration pass( Preprocessor::PROPAGATION );
+                    valid = parsePass( value.substr( start, end - start ), pass );
+                    configuration._passes.append( pass );
+                }
+
+                start = end + 1;
+            }
+        }
+        else
+        {
+            configuration._options[String( key.c_str() )] = String( value.c_str() );
+        }
+    }
+
+    free( buffer );
+    fclose( file );
+
+    if ( !valid )
+        throw CommonError( CommonError::READ_FAILED, "PortfolioRunner: invalid configuration file" );
+
+    return configurations;
+}
+
+unsigned PortfolioRunner::getNumberOfConfigurations() const
+{
+    return _configurations.size();
+}
+
+const PortfolioRunner::Configuration &PortfolioRunner::getConfiguration( unsigned index ) const
+{
+    return _configurations[index];
+}
+
+PortfolioRunner::Result PortfolioRunner::run()
+{
+    freeIfNeeded();
+
+    _cancel = false;
+    _winner = NO_WINNER;
+
+    for ( unsigned i = 0; i < _configurations.size(); ++i )
+    {
+        Instance instance;
+        instance._solver = _factory.createSolver( _configurations[i] );
+        instance._result = UNKNOWN;
+        instance._timeMicro = 0;
+        instance._failed = false;
+        _instances.append( instance );
+    }
+
+    std::vector<std::thread> threads;
+    for ( unsigned i = 0; i < _instances.size(); ++i )
+        threads.push_back( std::thread( &PortfolioRunner::runInstance, this, i ) );
+
+    for ( auto &thread : threads )
+        thread.join();
+
+    if ( _winner == NO_WINNER )
+        return UNKNOWN;
+
+    return _instances[_winner]._result;
+}
+
+void PortfolioRunner::runInstance( unsigned index )
+{
+    const Configuration &configuration( _configurations[index] );
+    Instance &instance( _instances[index] );
+
+    struct timespec start = TimeUtils::sampleMicro();
+
+    try
+    {
+        Preprocessor preprocessor;
+        if ( !configuration._passes.empty() )
+            preprocessor.setPasses( configuration._passes );
+
+        InputQuery preprocessed = preprocessor.preprocess( _query, configuration._attemptVariableElimination );
+
+        unsigned m = preprocessed.getEquations().size();
+        BasisFactorization factorization( m > 0 ? m : 1 );
+        factorization.setRefactorizationThreshold( configuration._refactorizationThreshold );
+
+        if ( !_cancel )
+            instance._result = instance._solver->solve( preprocessed, preprocessor, factorization, configuration, _cancel );
+    }
+    catch ( const InfeasibleQueryException & )
+    {
+        // Preprocessing alone refuted the query
+        instance._result = UNSAT;
+    }
+    catch ( ... )
+    {
+        instance._result = UNKNOWN;
+        instance._failed = true;
+    }
+
+    instance._timeMicro = TimeUtils::timePassed( start, TimeUtils::sampleMicro() );
+
+    if ( instance._result == UNKNOWN )
+        return;
+
+    unsigned noWinner = NO_WINNER;
+    if ( _winner.compare_exchange_strong( noWinner, index ) )
+        _cancel = true;
+}
+
+void PortfolioRunner::cancel()
+{
+    _cancel = true;
+}
+
+unsigned PortfolioRunner::getWinner() const
+{
+    return _winner;
+}
+
+PortfolioRunner::Solver *PortfolioRunner::getSolver( unsigned index ) const
+{
+    return _instances[index]._solver;
+}
+
+PortfolioRunner::Result PortfolioRunner::getResult( unsigned index ) const
+{
+    return _instances[index]._result;
+}
+
+unsigned long long PortfolioRunner::getTimeMicro( unsigned index ) const
+{
+    return _instances[index]._timeMicro;
+}
+
+bool PortfolioRunner::failed( unsigned index ) const
+{
+    return _instances[index]._failed;
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,177 @@
+/*********************                                                        */
+/*! \file PortfolioRunner.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __PortfolioRunner_h__
+#define __PortfolioRunner_h__
+
+#include "InputQuery.h"
+#include "List.h"
+#include "MString.h"
+#include "Map.h"
+#include "Preprocessor.h"
+#include "Vector.h"
+
+#include <atomic>
+
+class BasisFactorization;
+
+/*
+  Races several solver configurations on the same query. Each
+  configuration runs in its own thread, with its own preprocessor and
+  its own basis factorization. The first definitive answer wins, and
+  the other instances are asked to stop.
+
+  Configurations can be declared in a file of sections:
+
+      # comment
+      [no-elimination]
+      attemptVariableElimination = false
+      refactorizationThreshold = 50
+      passes = propagation:100 variable-elimination
+
+  Passes are named as by Preprocessor::getPassName(), optionally
+  followed by ":maxIterations" and ":maxTimeMicro". The
+  refactorization threshold must be a positive 32-bit value. Any other
+  key is kept as an option, for the solver to interpret.
+*/
+class PortfolioRunner
+{
+public:
+    enum Result {
+        UNSAT = 0,
+        SAT = 1,
+        UNKNOWN = 2,
+    };
+
+    enum {
+        NO_WINNER = 0xFFFFFFFF,
+    };
+
+    struct Configuration
+    {
+        Configuration();
+
+        String _name;
+        bool _attemptVariableElimination;
+        unsigned _refactorizationThreshold;
+
+        /*
+          Preprocessing passes; empty means the preprocessor's default.
+        */
+        List<Preprocessor::PassConfiguration> _passes;
+
+        /*
+          Settings for the solver itself.
+        */
+        Map<String, String> _options;
+    };
+
+    /*
+      Solves a preprocessed query. Solvers should poll the cancel flag
+      and return UNKNOWN once it is set.
+    */
+    class Solver
+    {
+    public:
+        virtual ~Solver() {}
+        virtual Result solve( const InputQuery &preprocessed,
+                              const Preprocessor &preprocessor,
+                              BasisFactorization &factorization,
+                              const Configuration &configuration,
+                              const std::atomic<bool> &cancel ) = 0;
+    };
+
+    /*
+      Creates one solver per configuration. The runner owns the
+      solvers it gets.
+    */
+    class SolverFactory
+    {
+    public:
+        virtual ~SolverFactory() {}
+        virtual Solver *createSolver( const Configuration &configuration ) = 0;
+    };
+
+    PortfolioRunner( const InputQuery &query, SolverFactory &factory );
+    ~PortfolioRunner();
+
+    /*
+      Free any allocated memory.
+    */
+    void freeIfNeeded();
+
+    /*
+      Add a configuration, or all the configurations declared in a
+      file. Malformed files cause a CommonError.
+    */
+    void addConfiguration( const Configuration &configuration );
+    void loadConfigurations( const String &path );
+    static List<Configuration> parseConfigurations( const String &path );
+
+    unsigned getNumberOfConfigurations() const;
+    const Configuration &getConfiguration( unsigned index ) const;
+
+    /*
+      Run all configurations, and return the first definitive answer,
+      or UNKNOWN if none gave one.
+    */
+    Result run();
+
+    /*
+      Ask all instances to stop, from any thread.
+    */
+    void cancel();
+
+    /*
+      The configuration that answered first, or NO_WINNER, and its
+      solver (which e.g. holds the satisfying assignment).
+    */
+    unsigned getWinner() const;
+    Solver *getSolver( unsigned index ) const;
+
+    /*
+      What each instance returned, and how long it ran.
+    */
+    Result getResult( unsigned index ) const;
+    unsigned long long getTimeMicro( unsigned index ) const;
+    bool failed( unsigned index ) const;
+
+private:
+    struct Instance
+    {
+        Solver *_solver;
+        Result _result;
+        unsigned long long _timeMicro;
+        bool _failed;
+    };
+
+    const InputQuery &_query;
+    SolverFactory &_factory;
+
+    Vector<Configuration> _configurations;
+    Vector<Instance> _instances;
+
+    std::atomic<bool> _cancel;
+    std::atomic<unsigned> _winner;
+
+    void runInstance( unsigned index );
+};
+
+#endif // __PortfolioRunner_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,168 @@
+/*********************                                                        */
+/*! \file PostsolveStack.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "Debug.h"
+#include "PostsolveStack.h"
+
+#include <cstring>
+
+PostsolveStack::PostsolveStack()
+    : _numberOfOriginalVariables( 0 )
+    , _numberOfVariables( 0 )
+{
+}
+
+void PostsolveStack::initialize( unsigned numberOfVariables )
+{
+    _records.clear();
+    _coefficients.clear();
+    _indices.clear();
+
+    _numberOfOriginalVariables = numberOfVariables;
+    _numberOfVariables = numberOfVariables;
+}
+
+void PostsolveStack::pushFixedVariable( unsigned variable, double value )
+{
+    ASSERT( variable < _numberOfVariables );
+
+    Record record;
+    record._type = FIXED_VARIABLE;
+    record._variable = variable;
+    record._value = value;
+    record._start = 0;
+    record._size = 0;
+
+    _records.append( record );
+}
+
+void PostsolveStack::pushSubstitution( unsigned variable, double scalar, const List<Equation::Addend> &addends )
+{
+    ASSERT( variable < _numberOfVariables );
+
+    Record record;
+    record._type = SUBSTITUTION;
+    record._variable = variable;
+    record._value = scalar;
+    record._start = _indices.size();
+    record._size = addends.size();
+
+    for ( const auto &addend : addends )
+    {
+        ASSERT( addend._variable != variable );
+        _coefficients.append( addend._coefficient );
+        _indices.append( addend._variable );
+    }
+
+    _records.append( record );
+}
+
+void PostsolveStack::pushIndexMap( unsigned numberOfNewVariables, const Map<unsigned, unsigned> &oldIndexToNewIndex )
+{
+    Record record;
+    record._type = INDEX_MAP;
+    record._variable = 0;
+    record._value = 0;
+    record._start = _indices.size();
+    record._size = _numberOfVariables;
+
+    // The coefficient array is kept aligned with the index array
+    for ( unsigned i = 0; i < _numberOfVariables; ++i )
+    {
+        if ( oldIndexToNewIndex.exists( i ) )
+        {
+            ASSERT( oldIndexToNewIndex.at( i ) <= i );
+            _indices.append( oldIndexToNewIndex.at( i ) );
+        }
+        else
+        {
+            _indices.append( ELIMINATED );
+        }
+
+        _coefficients.append( 0.0 );
+    }
+
+    _records.append( record );
+    _numberOfVariables = numberOfNewVariables;
+}
+
+unsigned PostsolveStack::getNumberOfOriginalVariables() const
+{
+    return _numberOfOriginalVariables;
+}
+
+unsigned PostsolveStack::getNumberOfReducedVariables() const
+{
+    return _numberOfVariables;
+}
+
+unsigned PostsolveStack::getNumberOfRecords() const
+{
+    return _records.size();
+}
+
+bool PostsolveStack::empty() const
+{
+    return _records.empty();
+}
+
+void PostsolveStack::postsolve( const double *reduced, double *original ) const
+{
+    memcpy( original, reduced, sizeof(double) * _numberOfVariables );
+
+    // Replay the records from last to first. The buffer always holds
+    // the assignment for the index space the current record was
+    // performed in.
+    for ( unsigned i = _records.size(); i > 0; --i )
+    {
+        const Record &record = _records[i - 1];
+
+        switch ( record._type )
+        {
+        case FIXED_VARIABLE:
+            original[record._variable] = record._value;
+            break;
+
+        case SUBSTITUTION:
+        {
+            double value = record._value;
+            for ( unsigned j = record._start; j < record._start + record._size; ++j )
+                value += _coefficients[j] * original[_indices[j]];
+            original[record._variable] = value;
+            break;
+        }
+
+        case INDEX_MAP:
+        {
+            // Spread the values back to their old indices. New indices
+            // never exceed old ones, so going from the highest old index
+            // down never overwrites a value that is still needed.
+            for ( unsigned j = record._size; j > 0; --j )
+            {
+                unsigned oldIndex = j - 1;
+                unsigned newIndex = _indices[record._start + oldIndex];
+                if ( newIndex != ELIMINATED )
+                    original[oldIndex] = original[newIndex];
+            }
+            break;
+        }
+        }
+    }
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,127 @@
+/*********************                                                        */
+/*! \file PostsolveStack.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __PostsolveStack_h__
+#define __PostsolveStack_h__
+
+#include "Equation.h"
+#include "List.h"
+#include "Map.h"
+#include "Vector.h"
+
+/*
+  An ordered record of the reductions performed by preprocessing, used
+  to map a solution of the reduced query back to an assignment of the
+  original query's variables.
+
+  Each reduction is recorded in the index space that was current when
+  it was performed:
+
+    - A fixed variable was removed, with a given value.
+    - A substituted variable was removed, and equals a scalar plus a
+      linear combination of other variables.
+    - The variable indices were compacted, mapping each surviving old
+      index to a (smaller or equal) new index.
+
+  Postsolving replays the records in reverse order over a single
+  buffer, so its cost is linear in the total size of the records.
+*/
+class PostsolveStack
+{
+public:
+    enum {
+        ELIMINATED = 0xFFFFFFFF,
+    };
+
+    PostsolveStack();
+
+    /*
+      Start a new stack for a query with the given number of variables.
+    */
+    void initialize( unsigned numberOfVariables );
+
+    /*
+      Record a variable that was fixed and removed.
+    */
+    void pushFixedVariable( unsigned variable, double value );
+
+    /*
+      Record a variable that was removed after being expressed as
+      variable = scalar + sum( coefficient_i * x_i ).
+    */
+    void pushSubstitution( unsigned variable, double scalar, const List<Equation::Addend> &addends );
+
+    /*
+      Record a compaction of the variable indices. Old indices that do
+      not appear in the map must have been removed by earlier records.
+    */
+    void pushIndexMap( unsigned numberOfNewVariables, const Map<unsigned, unsigned> &oldIndexToNewIndex );
+
+    /*
+      The number of variables before and after all recorded reductions.
+    */
+    unsigned getNumberOfOriginalVariables() const;
+    unsigned getNumberOfReducedVariables() const;
+
+    unsigned getNumberOfRecords() const;
+    bool empty() const;
+
+    /*
+      Map a solution of the reduced query (of size
+      getNumberOfReducedVariables()) to an assignment of the original
+      variables (of size getNumberOfOriginalVariables()).
+    */
+    void postsolve( const double *reduced, double *original ) const;
+
+private:
+    enum RecordType {
+        FIXED_VARIABLE,
+        SUBSTITUTION,
+        INDEX_MAP,
+    };
+
+    struct Record
+    {
+        RecordType _type;
+
+        // Fixed and substituted variables: the variable and its value,
+        // or the substitution's scalar
+        unsigned _variable;
+        double _value;
+
+        // Substitutions and index maps: a range within the flat arrays
+        unsigned _start;
+        unsigned _size;
+    };
+
+    Vector<Record> _records;
+
+    /*
+      Addends of substitutions, and old-to-new index maps (one entry per
+      old index), stored contiguously.
+    */
+    Vector<double> _coefficients;
+    Vector<unsigned> _indices;
+
+    unsigned _numberOfOriginalVariables;
+    unsigned _numberOfVariables;
+};
+
+#endif // __PostsolveStack_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
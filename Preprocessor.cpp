@@ -10,195 +10,174 @@
  ** directory for licensing information.\endverbatim
  **/
 
+#include "BoundPropagator.h"
 #include "FloatUtils.h"
+#include "HashUtils.h"
 #include "InfeasibleQueryException.h"
 #include "InputQuery.h"
 #include "MStringf.h"
 #include "Map.h"
 #include "Preprocessor.h"
+#include "PreprocessorCache.h"
+#include "Probes.h"
 #include "ReluplexError.h"
 #include "Statistics.h"
 #include "Tightening.h"
+#include "TimeUtils.h"
+#include "TraceRecorder.h"
 
 Preprocessor::Preprocessor()
     : _statistics( NULL )
+    , _cache( NULL )
 {
 }
 
 InputQuery Preprocessor::preprocess( const InputQuery &query, bool attemptVariableElimination )
 {
+    TRACE_SCOPE( "preprocess", "preprocessing" );
+
     _preprocessed = query;
+    _postsolveStack.initialize( query.getNumberOfVariables() );
+    _passStatistics.clear();
+    _fixedVariables.clear();
+    _oldIndexToNewIndex.clear();
 
     /*
-      Do the preprocessing steps:
+      Run the preprocessing passes in order. Unless configured otherwise,
+      the passes are:
+
+      1. Until saturation:
+           a. Tighten bounds using equations
+           b. Tighten bounds using pl constraints
 
-      Until saturation:
-        1. Tighten bounds using equations
-        2. Tighten bounds using pl constraints
+      2. Eliminate fixed variables.
 
-      Then, eliminate fixed variables.
+      If a cache is available and holds the tightened bounds for this
+      query, start from those bounds: the tightening passes then only
+      verify that they are saturated. The cache holds the bounds as
+      they are before the first elimination pass. A pass with a budget
+      would go further from cached bounds than from the query's own,
+      so when one runs before elimination the cache is not used.
     */
 
-    bool continueTightening = true;
-    while ( continueTightening )
+    List<PassConfiguration> passes = _passes;
+    if ( passes.empty() )
     {
-        continueTightening = processEquations();
-        continueTightening = processConstraints() || continueTightening;
-
-        if ( _statistics )
-            _statistics->ppIncNumTighteningIterations();
+        passes.append( PassConfiguration( PROPAGATION ) );
+        passes.append( PassConfiguration( VARIABLE_ELIMINATION ) );
     }
 
-    if ( attemptVariableElimination )
-        eliminateFixedVariables();
+    uint64_t cacheKey = 0;
+    bool cacheHit = false;
+    bool cacheStored = false;
+    PreprocessorCache *cache = _cache;
+    if ( cache && !PreprocessorCache::computeKey( query, attemptVariableElimination, cacheKey ) )
+        cache = NULL;
 
-	return _preprocessed;
-}
+    for ( const auto &pass : passes )
+    {
+        if ( !cache || ( pass._type == VARIABLE_ELIMINATION ) )
+            break;
 
-bool Preprocessor::processEquations()
-{
-    bool tighterBoundFound = false;
+        if ( ( pass._maxIterations != 0 ) || ( pass._maxTimeMicro != 0 ) )
+            cache = NULL;
+        else
+            cacheKey = HashUtils::hashUnsigned( pass._type, cacheKey );
+    }
+
+    if ( cache )
+        cacheHit = cache->load( cacheKey, _preprocessed );
 
-    for ( const auto &equation : _preprocessed.getEquations() )
+    bool eliminationPerformed = false;
+    for ( const auto &pass : passes )
     {
-        for ( const auto &varBeingTightened : equation._addends )
+        if ( pass._type == VARIABLE_ELIMINATION )
         {
-            // The equation is of the form a * varBeingTightened + sum (bi * xi) = c,
-            // or: a * varBeingTightened = c - sum (bi * xi)
+            // Elimination renumbers the variables, and the index maps
+            // describe a single renumbering, so it can only happen once
+            if ( !attemptVariableElimination || eliminationPerformed )
+                continue;
 
-            // We first compute the lower and upper bounds for the expression c - sum (bi * xi)
-            double scalarUB = equation._scalar;
-            double scalarLB = equation._scalar;
-            bool validLB = true;
-            bool validUB = true;
-
-            for ( auto addend : equation._addends )
+            if ( cache && !cacheHit && !cacheStored )
             {
-                if ( varBeingTightened._variable == addend._variable )
-                    continue;
+                cache->store( cacheKey, BoundPropagator( _preprocessed ) );
+                cacheStored = true;
+            }
 
-                if ( FloatUtils::isNegative( addend._coefficient ) )
-                {
-                    if ( validLB )
-                    {
-                        double addendLB = _preprocessed.getLowerBound( addend._variable );
-                        if ( FloatUtils::isFinite( addendLB ) )
-                            scalarLB -= addend._coefficient * addendLB;
-                        else
-                            validLB = false;
-                    }
+            eliminationPerformed = true;
+        }
 
-                    if ( validUB )
-                    {
-                        double addendUB = _preprocessed.getUpperBound( addend._variable );
-                        if ( FloatUtils::isFinite( addendUB ) )
-                            scalarUB -= addend._coefficient * addendUB;
-                        else
-                            validUB = false;
-                    }
-                }
+        runPass( pass );
+    }
 
-                if ( FloatUtils::isPositive( addend._coefficient ) )
-                {
-                    if ( validLB )
-                    {
-                        double addendUB = _preprocessed.getUpperBound( addend._variable );
-                        if ( FloatUtils::isFinite( addendUB ) )
-                            scalarLB -= addend._coefficient * addendUB;
-                        else
-                            validLB = false;
-                    }
+    if ( cache && !cacheHit && !cacheStored )
+        cache->store( cacheKey, BoundPropagator( _preprocessed ) );
 
-                    if ( validUB )
-                    {
-                        double addendLB = _preprocessed.getLowerBound( addend._variable );
-                        if ( FloatUtils::isFinite( addendLB ) )
-                            scalarUB -= addend._coefficient * addendLB;
-                        else
-                            validUB = false;
-                    }
-                }
-            }
+	return _preprocessed;
+}
 
-            // We know that lb < a * varBeingTightened < ub. We want to divide by a, but we care about the sign
-            // If a is positive: lb/a < x < ub/a
-            // If a is negative: lb/a > x > ub/a
-            if ( validLB )
-                scalarLB = scalarLB / varBeingTightened._coefficient;
-            if ( validUB )
-                scalarUB = scalarUB / varBeingTightened._coefficient;
+void Preprocessor::runPass( const PassConfiguration &pass )
+{
+    TRACE_SCOPE( getPassLiteral( pass._type ), "preprocessing" );
 
-            if ( FloatUtils::isNegative( varBeingTightened._coefficient ) )
-            {
-                double temp = scalarUB;
-                scalarUB = scalarLB;
-                scalarLB = temp;
+    PassStatistics statistics;
+    statistics._type = pass._type;
+    statistics._numIterations = 0;
+    statistics._numBoundsTightened = 0;
+    statistics._numVariablesRemoved = 0;
+    statistics._budgetExhausted = false;
 
-                bool tempValid = validUB;
-                validUB = validLB;
-                validLB = tempValid;
-            }
+    struct timespec start = TimeUtils::sampleMicro();
 
-            if ( validLB && FloatUtils::gt( scalarLB, _preprocessed.getLowerBound( varBeingTightened._variable ),
-                                            GlobalConfiguration::BOUND_COMPARISON_TOLERANCE ) )
-            {
-                tighterBoundFound = true;
-                _preprocessed.setLowerBound( varBeingTightened._variable, scalarLB );
-            }
+    if ( pass._type == VARIABLE_ELIMINATION )
+    {
+        unsigned numberOfVariables = _preprocessed.getNumberOfVariables();
+        eliminateFixedVariables();
+        statistics._numVariablesRemoved = numberOfVariables - _preprocessed.getNumberOfVariables();
+        statistics._numIterations = 1;
+    }
+    else
+    {
+        BoundPropagator propagator( _preprocessed );
+        const List<Equation> &equations( _preprocessed.getEquations() );
+        const List<PiecewiseLinearConstraint *> &constraints( _preprocessed.getPiecewiseLinearConstraints() );
 
-            if ( validUB && FloatUtils::lt( scalarUB, _preprocessed.getUpperBound( varBeingTightened._variable ),
-                                            GlobalConfiguration::BOUND_COMPARISON_TOLERANCE ) )
+        bool continueTightening = true;
+        while ( continueTightening )
+        {
+            if ( ( pass._maxIterations != 0 ) && ( statistics._numIterations >= pass._maxIterations ) )
             {
-                tighterBoundFound = true;
-                _preprocessed.setUpperBound( varBeingTightened._variable, scalarUB );
+                statistics._budgetExhausted = true;
+                break;
             }
 
-            if ( FloatUtils::gt( _preprocessed.getLowerBound( varBeingTightened._variable ),
-                                 _preprocessed.getUpperBound( varBeingTightened._variable ),
-                                 GlobalConfiguration::BOUND_COMPARISON_TOLERANCE ) )
+            if ( ( pass._maxTimeMicro != 0 ) &&
+                 ( TimeUtils::timePassed( start, TimeUtils::sampleMicro() ) >= pass._maxTimeMicro ) )
             {
-                throw InfeasibleQueryException();
+                statistics._budgetExhausted = true;
+                break;
             }
-        }
-    }
 
-    return tighterBoundFound;
-}
+            TraceRecorder::Scope trace( "tightening-iteration", "preprocessing" );
+            trace.setArgument( statistics._numIterations );
 
-bool Preprocessor::processConstraints()
-{
-    bool tighterBoundFound = false;
+            continueTightening = false;
+            if ( pass._type != CONSTRAINT_PROPAGATION )
+                continueTightening = propagator.processEquations( equations );
+            if ( pass._type != EQUATION_PROPAGATION )
+                continueTightening = propagator.processConstraints( constraints ) || continueTightening;
 
-	for ( auto &constraint : _preprocessed.getPiecewiseLinearConstraints() )
-	{
-		for ( unsigned variable : constraint->getParticipatingVariables() )
-		{
-			constraint->notifyLowerBound( variable, _preprocessed.getLowerBound( variable ) );
-			constraint->notifyUpperBound( variable, _preprocessed.getUpperBound( variable ) );
-		}
-
-        List<Tightening> tightenings;
-        constraint->getEntailedTightenings( tightenings );
-
-        for ( const auto &tightening : tightenings )
-		{
-			if ( ( tightening._type == Tightening::LB ) &&
-                 FloatUtils::gt( tightening._value, _preprocessed.getLowerBound( tightening._variable ) ) )
-            {
-                tighterBoundFound = true;
-                _preprocessed.setLowerBound( tightening._variable, tightening._value );
-            }
+            ++statistics._numIterations;
+            if ( _statistics )
+                _statistics->ppIncNumTighteningIterations();
+        }
 
-			else if ( ( tightening._type == Tightening::UB ) &&
-				 FloatUtils::lt( tightening._value, _preprocessed.getUpperBound( tightening._variable ) ) )
-            {
-                tighterBoundFound = true;
-                _preprocessed.setUpperBound( tightening._variable, tightening._value );
-            }
-		}
-	}
+        propagator.storeBounds( _preprocessed );
+        statistics._numBoundsTightened = propagator.getNumTightenings();
+    }
 
-    return tighterBoundFound;
+    statistics._timeMicro = TimeUtils::timePassed( start, TimeUtils::sampleMicro() );
+    _passStatistics.append( statistics );
 }
 
 void Preprocessor::eliminateFixedVariables()
@@ -217,6 +196,14 @@ void Preprocessor::eliminateFixedVariables()
     if ( _statistics )
         _statistics->ppSetNumEliminatedVars( _fixedVariables.size() );
 
+    MARABOU_PROBE2( eliminate__begin, _preprocessed.getNumberOfVariables(), _fixedVariables.size() );
+
+    for ( const auto &fixed : _fixedVariables )
+    {
+        MARABOU_PROBE2( variable__eliminate, fixed.first, Probes::bits( fixed.second ) );
+        _postsolveStack.pushFixedVariable( fixed.first, fixed.second );
+    }
+
     // Compute the new variable indices, after the elimination of fixed variables
  	int offset = 0;
 	for ( unsigned i = 0; i < _preprocessed.getNumberOfVariables(); ++i )
@@ -227,6 +214,9 @@ void Preprocessor::eliminateFixedVariables()
             _oldIndexToNewIndex[i] = i - offset;
 	}
 
+    _postsolveStack.pushIndexMap( _preprocessed.getNumberOfVariables() - _fixedVariables.size(),
+                                  _oldIndexToNewIndex );
+
     // Next, eliminate the fixed variables from the equations
     List<Equation> &equations( _preprocessed.getEquations() );
     List<Equation>::iterator equation = equations.begin();
@@ -353,11 +343,68 @@ unsigned Preprocessor::getNewIndex( unsigned oldIndex ) const
     return oldIndex;
 }
 
+const PostsolveStack &Preprocessor::getPostsolveStack() const
+{
+    return _postsolveStack;
+}
+
+void Preprocessor::setPasses( const List<PassConfiguration> &passes )
+{
+    _passes = passes;
+}
+
+const List<Preprocessor::PassStatistics> &Preprocessor::getPassStatistics() const
+{
+    return _passStatistics;
+}
+
+String Preprocessor::getPassName( PassType type )
+{
+    return getPassLiteral( type );
+}
+
+const char *Preprocessor::getPassLiteral( PassType type )
+{
+    switch ( type )
+    {
+    case PROPAGATION:
+        return "propagation";
+    case EQUATION_PROPAGATION:
+        return "equation-propagation";
+    case CONSTRAINT_PROPAGATION:
+        return "constraint-propagation";
+    case VARIABLE_ELIMINATION:
+        return "variable-elimination";
+    }
+
+    return "unknown";
+}
+
+void Preprocessor::printPassStatistics() const
+{
+    printf( "Preprocessor passes:\n" );
+    for ( const auto &pass : _passStatistics )
+    {
+        printf( "\t%s: %u iterations, %u bounds tightened, %u variables removed, %llu micro%s\n",
+                getPassName( pass._type ).ascii(),
+                pass._numIterations,
+                pass._numBoundsTightened,
+                pass._numVariablesRemoved,
+                pass._timeMicro,
+                pass._budgetExhausted ? " (budget exhausted)" : "" );
+    }
+}
+
 void Preprocessor::setStatistics( Statistics *statistics )
 {
     _statistics = statistics;
 }
 
+void Preprocessor::setCache( PreprocessorCache *cache )
+{
+    _cache = cache;
+}
+
 //
 // Local Variables:
 // compile-command: "make -C ../.. "
@@ -15,13 +15,62 @@
 
 #include "Equation.h"
 #include "List.h"
+#include "MString.h"
 #include "Map.h"
 #include "PiecewiseLinearConstraint.h"
 #include "InputQuery.h"
+#include "PostsolveStack.h"
+
+class PreprocessorCache;
 
 class Preprocessor
 {
 public:
+    /*
+      The available preprocessing passes.
+    */
+    enum PassType {
+        // Tighten bounds using the equations and the pl constraints
+        PROPAGATION = 0,
+        // Tighten bounds using only the equations, or only the pl constraints
+        EQUATION_PROPAGATION = 1,
+        CONSTRAINT_PROPAGATION = 2,
+        // Eliminate variables that have become fixed
+        VARIABLE_ELIMINATION = 3,
+    };
+
+    /*
+      A pass in the pipeline, with its budget. Tightening passes stop
+      at saturation, or once they have run the given number of
+      iterations or the given time; 0 means no limit.
+    */
+    struct PassConfiguration
+    {
+        PassConfiguration( PassType type, unsigned maxIterations = 0, unsigned long long maxTimeMicro = 0 )
+            : _type( type )
+            , _maxIterations( maxIterations )
+            , _maxTimeMicro( maxTimeMicro )
+        {
+        }
+
+        PassType _type;
+        unsigned _maxIterations;
+        unsigned long long _maxTimeMicro;
+    };
+
+    /*
+      What a single run of a pass did.
+    */
+    struct PassStatistics
+    {
+        PassType _type;
+        unsigned _numIterations;
+        unsigned _numBoundsTightened;
+        unsigned _numVariablesRemoved;
+        unsigned long long _timeMicro;
+        bool _budgetExhausted;
+    };
+
     Preprocessor();
 
     /*
@@ -29,11 +78,35 @@ public:
     */
     InputQuery preprocess( const InputQuery &query, bool attemptVariableElimination = true );
 
+    /*
+      Set the passes to run, in order. By default, preprocessing runs a
+      propagation pass until saturation and then eliminates fixed
+      variables. Elimination passes are skipped if elimination is not
+      attempted, and only the first one is ever run.
+    */
+    void setPasses( const List<PassConfiguration> &passes );
+
+    /*
+      Per-pass statistics of the last call to preprocess(), in the
+      order the passes ran.
+    */
+    const List<PassStatistics> &getPassStatistics() const;
+    void printPassStatistics() const;
+    static String getPassName( PassType type );
+
     /*
       Have the preprocessor start reporting statistics.
     */
     void setStatistics( Statistics *statistics );
 
+    /*
+      Have the preprocessor look up and store its results in an
+      on-disk cache. Queries with constraints of unknown kinds (see
+      ConstraintKind), and runs with a budgeted pass before variable
+      elimination, are not cached.
+    */
+    void setCache( PreprocessorCache *cache );
+
     /*
       Obtain the values of variabels that have become fixed.
     */
@@ -45,16 +118,23 @@ public:
     */
     unsigned getNewIndex( unsigned oldIndex ) const;
 
+    /*
+      The reductions performed by the last call to preprocess(), which
+      map a solution of the preprocessed query back to the original
+      variables in a single pass.
+    */
+    const PostsolveStack &getPostsolveStack() const;
+
 private:
-	/*
-      Tighten bounds using the linear equations
-	*/
-	bool processEquations();
+    /*
+      Run a single pass, and record its statistics.
+    */
+    void runPass( const PassConfiguration &pass );
 
     /*
-      Tighten the bounds using the piecewise linear constraints
-	*/
-	bool processConstraints();
+      The name of a pass as a string literal, for tracing.
+    */
+    static const char *getPassLiteral( PassType type );
 
     /*
       Eliminate any variables that have become files
@@ -63,11 +143,22 @@ private:
 
     InputQuery _preprocessed;
 
+    /*
+      The configured passes, and the statistics of the last run.
+    */
+    List<PassConfiguration> _passes;
+    List<PassStatistics> _passStatistics;
+
     /*
       Statistics collection
     */
     Statistics *_statistics;
 
+    /*
+      Cache of preprocessing results, if one is used.
+    */
+    PreprocessorCache *_cache;
+
     /*
       Variables that have become fixed during preprocessing, and the
       values that they have been fixed to.
@@ -79,6 +170,11 @@ private:
       indices were changed during preprocessing.
     */
     Map<unsigned, unsigned> _oldIndexToNewIndex;
+
+    /*
+      The reductions performed, in order.
+    */
+    PostsolveStack _postsolveStack;
 };
 
 #endif // __Preprocessor_h__
@@ -0,0 +1,292 @@
+/*********************                                                        */
+/*! \file PreprocessorCache.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "BoundPropagator.h"
+#include "ConstraintKind.h"
+#include "FloatUtils.h"
+#include "GlobalConfiguration.h"
+#include "HashUtils.h"
+#include "InputQuery.h"
+#include "MStringf.h"
+#include "PreprocessorCache.h"
+#include "Vector.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+namespace
+{
+    const uint32_t CACHE_MAGIC = 0x4350504d; // "MPPC"
+    const uint32_t CACHE_VERSION = 2;
+    const char *CACHE_SUFFIX = ".ppcache";
+
+    struct CacheEntryHeader
+    {
+        uint32_t _magic;
+        uint32_t _version;
+        uint64_t _key;
+        uint64_t _numberOfVariables;
+        uint64_t _checksum;
+    };
+
+    struct CacheFileInfo
+    {
+        String _path;
+        time_t _lastUsed;
+        uint64_t _size;
+
+        bool operator<( const CacheFileInfo &other ) const
+        {
+            return _lastUsed < other._lastUsed;
+        }
+    };
+}
+
+PreprocessorCache::PreprocessorCache( const String &directory, unsigned maxEntries, uint64_t maxBytes )
+    : _directory( directory )
+    , _maxEntries( maxEntries )
+    , _maxBytes( maxBytes )
+    , _numHits( 0 )
+    , _numMisses( 0 )
+{
+}
+
+bool PreprocessorCache::computeKey( const InputQuery &query, bool attemptVariableElimination, uint64_t &key )
+{
+    key = HashUtils::FNV_OFFSET_BASIS;
+
+    // Preprocessing options and the format versions
+    key = HashUtils::hashUnsigned( CACHE_VERSION, key );
+    key = HashUtils::hashUnsigned( ConstraintKind::VERSION, key );
+    key = HashUtils::hashUnsigned( attemptVariableElimination, key );
+    key = HashUtils::hashDouble( GlobalConfiguration::BOUND_COMPARISON_TOLERANCE, key );
+
+    // Variables and bounds
+    unsigned n = query.getNumberOfVariables();
+    key = HashUtils::hashUnsigned( n, key );
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        key = HashUtils::hashDouble( query.getLowerBound( i ), key );
+        key = HashUtils::hashDouble( query.getUpperBound( i ), key );
+    }
+
+    // Equations
+    const List<Equation> &equations( query.getEquations() );
+    key = HashUtils::hashUnsigned( equations.size(), key );
+    for ( const auto &equation : equations )
+    {
+        key = HashUtils::hashUnsigned( equation._addends.size(), key );
+        for ( const auto &addend : equation._addends )
+        {
+            key = HashUtils::hashDouble( addend._coefficient, key );
+            key = HashUtils::hashUnsigned( addend._variable, key );
+        }
+
+        key = HashUtils::hashDouble( equation._scalar, key );
+        key = HashUtils::hashUnsigned( equation._auxVariable, key );
+    }
+
+    // Piecewise linear constraints, identified by their kind and
+    // participating variables
+    const List<PiecewiseLinearConstraint *> &constraints( query.getPiecewiseLinearConstraints() );
+    key = HashUtils::hashUnsigned( constraints.size(), key );
+    for ( const auto &constraint : constraints )
+    {
+        ConstraintKind::Kind kind = ConstraintKind::of( constraint );
+        if ( kind == ConstraintKind::UNKNOWN )
+            return false;
+
+        key = HashUtils::hashUnsigned( kind, key );
+
+        List<unsigned> variables = constraint->getParticipatingVariables();
+        key = HashUtils::hashUnsigned( variables.size(), key );
+        for ( unsigned variable : variables )
+            key = HashUtils::hashUnsigned( variable, key );
+    }
+
+    return true;
+}
+
+String PreprocessorCache::getEntryPath( uint64_t key ) const
+{
+    return _directory + Stringf( "/%016llx%s", (unsigned long long)key, CACHE_SUFFIX );
+}
+
+bool PreprocessorCache::load( uint64_t key, InputQuery &query )
+{
+    String path = getEntryPath( key );
+    FILE *file = fopen( path.ascii(), "rb" );
+    if ( !file )
+    {
+        ++_numMisses;
+        return false;
+    }
+
+    unsigned n = query.getNumberOfVariables();
+    CacheEntryHeader header;
+    double *bounds = new double[2 * n];
+
+    bool valid =
+        ( fread( &header, sizeof(header), 1, file ) == 1 ) &&
+        ( header._magic == CACHE_MAGIC ) &&
+        ( header._version == CACHE_VERSION ) &&
+        ( header._key == key ) &&
+        ( header._numberOfVariables == n ) &&
+        ( fread( bounds, sizeof(double), 2 * n, file ) == 2 * n ) &&
+        ( fgetc( file ) == EOF ) &&
+        ( HashUtils::hash( bounds, sizeof(double) * 2 * n ) == header._checksum );
+
+    fclose( file );
+
+    // Cached bounds can only be tighter than the query's own bounds
+    for ( unsigned i = 0; valid && i < n; ++i )
+    {
+        if ( FloatUtils::lt( bounds[i], query.getLowerBound( i ) ) ||
+             FloatUtils::gt( bounds[n + i], query.getUpperBound( i ) ) )
+            valid = false;
+    }
+
+    if ( !valid )
+    {
+        delete[] bounds;
+        unlink( path.ascii() );
+        ++_numMisses;
+        return false;
+    }
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        query.setLowerBound( i, bounds[i] );
+        query.setUpperBound( i, bounds[n + i] );
+    }
+
+    delete[] bounds;
+
+    // Mark the entry as recently used
+    utime( path.ascii(), NULL );
+
+    ++_numHits;
+    return true;
+}
+
+void PreprocessorCache::store( uint64_t key, const BoundPropagator &propagator )
+{
+    unsigned n = propagator.getNumberOfVariables();
+    double *bounds = new double[2 * n];
+    memcpy( bounds, propagator.getLowerBounds(), sizeof(double) * n );
+    memcpy( bounds + n, propagator.getUpperBounds(), sizeof(double) * n );
+
+    CacheEntryHeader header;
+    header._magic = CACHE_MAGIC;
+    header._version = CACHE_VERSION;
+    header._key = key;
+    header._numberOfVariables = n;
+    header._checksum = HashUtils::hash( bounds, sizeof(double) * 2 * n );
+
+    // Write to a temporary file and rename it, so that concurrent
+    // readers never see a partial entry
+    String path = getEntryPath( key );
+    String temporaryPath = path + Stringf( ".%u.tmp", (unsigned)getpid() );
+
+    FILE *file = fopen( temporaryPath.ascii(), "wb" );
+    if ( file )
+    {
+        bool written =
+            ( fwrite( &header, sizeof(header), 1, file ) == 1 ) &&
+            ( fwrite( bounds, sizeof(double), 2 * n, file ) == 2 * n );
+
+        if ( ( fclose( file ) == 0 ) && written )
+            rename( temporaryPath.ascii(), path.ascii() );
+        else
+            unlink( temporaryPath.ascii() );
+    }
+
+    delete[] bounds;
+
+    evict();
+}
+
+void PreprocessorCache::evict()
+{
+    if ( ( _maxEntries == 0 ) && ( _maxBytes == 0 ) )
+        return;
+
+    DIR *directory = opendir( _directory.ascii() );
+    if ( !directory )
+        return;
+
+    Vector<CacheFileInfo> entries;
+    uint64_t totalBytes = 0;
+    unsigned suffixLength = strlen( CACHE_SUFFIX );
+
+    struct dirent *directoryEntry;
+    while ( ( directoryEntry = readdir( directory ) ) != NULL )
+    {
+        unsigned length = strlen( directoryEntry->d_name );
+        if ( ( length <= suffixLength ) ||
+             ( strcmp( directoryEntry->d_name + length - suffixLength, CACHE_SUFFIX ) != 0 ) )
+            continue;
+
+        CacheFileInfo info;
+        info._path = _directory + "/" + directoryEntry->d_name;
+
+        struct stat fileStatus;
+        if ( stat( info._path.ascii(), &fileStatus ) != 0 )
+            continue;
+
+        info._lastUsed = fileStatus.st_mtime;
+        info._size = fileStatus.st_size;
+        totalBytes += info._size;
+        entries.append( info );
+    }
+
+    closedir( directory );
+
+    std::sort( entries.begin(), entries.end() );
+
+    unsigned numEntries = entries.size();
+    for ( const auto &entry : entries )
+    {
+        bool tooManyEntries = ( _maxEntries != 0 ) && ( numEntries > _maxEntries );
+        bool tooManyBytes = ( _maxBytes != 0 ) && ( totalBytes > _maxBytes );
+        if ( !tooManyEntries && !tooManyBytes )
+            break;
+
+        if ( unlink( entry._path.ascii() ) == 0 )
+        {
+            --numEntries;
+            totalBytes -= entry._size;
+        }
+    }
+}
+
+unsigned PreprocessorCache::getNumHits() const
+{
+    return _numHits;
+}
+
+unsigned PreprocessorCache::getNumMisses() const
+{
+    return _numMisses;
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
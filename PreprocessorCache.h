@@ -0,0 +1,95 @@
+/*********************                                                        */
+/*! \file PreprocessorCache.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __PreprocessorCache_h__
+#define __PreprocessorCache_h__
+
+#include "MString.h"
+
+#include <stdint.h>
+
+class BoundPropagator;
+class InputQuery;
+
+/*
+  An on-disk cache of preprocessing results. Entries are keyed by a
+  stable hash of the input query (bounds, equations and piecewise
+  linear constraints) and of the preprocessing options, and hold the
+  bounds obtained by tightening until saturation, which is the
+  expensive part of preprocessing. On a hit the preprocessor starts
+  from the cached bounds; the remaining work (one verification round
+  of tightening, and the elimination of fixed variables, which also
+  rebuilds the index maps) is linear in the size of the query.
+
+  Each entry is a separate file carrying a format version, its key and
+  a checksum of its contents. Entries that fail these checks, or whose
+  bounds are looser than the query's, are ignored and deleted. When the
+  cache grows beyond its limits, the least recently used entries are
+  evicted.
+*/
+class PreprocessorCache
+{
+public:
+    /*
+      Use the given directory, which must already exist. A limit of 0
+      means no limit.
+    */
+    PreprocessorCache( const String &directory, unsigned maxEntries = 1000, uint64_t maxBytes = 0 );
+
+    /*
+      Compute the cache key for a query and preprocessing options.
+      Returns false if the query has a constraint whose kind has no
+      stable identifier, in which case it cannot be cached.
+    */
+    static bool computeKey( const InputQuery &query, bool attemptVariableElimination, uint64_t &key );
+
+    /*
+      Look for an entry and, if a valid one is found, store its bounds
+      in the query. Returns true on a hit.
+    */
+    bool load( uint64_t key, InputQuery &query );
+
+    /*
+      Store the bounds held by a propagator under the given key, and
+      evict old entries if needed.
+    */
+    void store( uint64_t key, const BoundPropagator &propagator );
+
+    /*
+      Remove least recently used entries until the cache is within its
+      limits.
+    */
+    void evict();
+
+    unsigned getNumHits() const;
+    unsigned getNumMisses() const;
+
+private:
+    String _directory;
+    unsigned _maxEntries;
+    uint64_t _maxBytes;
+
+    unsigned _numHits;
+    unsigned _numMisses;
+
+    String getEntryPath( uint64_t key ) const;
+};
+
+#endif // __PreprocessorCache_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,36 @@
+/*********************                                                        */
+/*! \file Probes.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "Probes.h"
+
+#ifdef MARABOU_PROBES_ENABLED
+
+// The semaphores of the probes, which tracers increment while attached
+MARABOU_DEFINE_PROBE( refactorize );
+MARABOU_DEFINE_PROBE( eta__push );
+MARABOU_DEFINE_PROBE( ftran__entry );
+MARABOU_DEFINE_PROBE( ftran__return );
+MARABOU_DEFINE_PROBE( btran__entry );
+MARABOU_DEFINE_PROBE( btran__return );
+MARABOU_DEFINE_PROBE( bound__tighten );
+MARABOU_DEFINE_PROBE( variable__eliminate );
+MARABOU_DEFINE_PROBE( eliminate__begin );
+
+#endif // MARABOU_PROBES_ENABLED
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,114 @@
+/*********************                                                        */
+/*! \file Probes.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __Probes_h__
+#define __Probes_h__
+
+#include <cstring>
+
+/*
+  Static tracepoints (USDT probes) for observing a running solver with
+  bpftrace, perf or SystemTap, without rebuilding it. For example:
+
+    bpftrace -e 'usdt:./Marabou:marabou:refactorize { @[arg1] = count(); }'
+
+  An unattached probe is a single nop. Probes whose arguments are costly
+  to compute (e.g. counting nonzeros) test MARABOU_PROBE_ENABLED first,
+  which reads the probe's semaphore; tracers set the semaphore while
+  attached.
+
+  The probes are built in whenever <sys/sdt.h> (from the systemtap-sdt
+  development package) is available on Linux, unless MARABOU_NO_PROBES
+  is defined; otherwise all of the macros below expand to nothing.
+
+  Provider "marabou", probes and arguments:
+
+    refactorize           m, number of etas
+    eta__push             m, column index, column nonzeros
+    ftran__entry          m, input nonzeros
+    ftran__return         m, output nonzeros
+    btran__entry          m, input nonzeros
+    btran__return         m, output nonzeros
+    bound__tighten        variable, 1 for an upper bound (0 for lower), new bound
+    variable__eliminate   variable, fixed value
+    eliminate__begin      number of variables, number of fixed variables
+
+  Bounds and values are passed as the raw bits of the double, since
+  not all tracers can read floating point arguments; in bpftrace they
+  can be reinterpreted from a 64 bit integer.
+*/
+
+#if !defined( MARABOU_NO_PROBES ) && defined( __linux__ ) && defined( __has_include )
+#if __has_include( <sys/sdt.h> )
+#define MARABOU_PROBES_ENABLED
+#endif
+#endif
+
+#ifdef MARABOU_PROBES_ENABLED
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define MARABOU_PROBE_SEMAPHORE( name ) marabou_##name##_semaphore
+#define MARABOU_DEFINE_PROBE( name ) \
+    unsigned short MARABOU_PROBE_SEMAPHORE( name ) __attribute__(( section( ".probes" ) )) = 0
+#define MARABOU_DECLARE_PROBE( name ) extern unsigned short MARABOU_PROBE_SEMAPHORE( name )
+
+#define MARABOU_PROBE_ENABLED( name ) \
+    __builtin_expect( *(volatile unsigned short *)&MARABOU_PROBE_SEMAPHORE( name ) != 0, 0 )
+
+#define MARABOU_PROBE1( name, a ) DTRACE_PROBE1( marabou, name, a )
+#define MARABOU_PROBE2( name, a, b ) DTRACE_PROBE2( marabou, name, a, b )
+#define MARABOU_PROBE3( name, a, b, c ) DTRACE_PROBE3( marabou, name, a, b, c )
+
+MARABOU_DECLARE_PROBE( refactorize );
+MARABOU_DECLARE_PROBE( eta__push );
+MARABOU_DECLARE_PROBE( ftran__entry );
+MARABOU_DECLARE_PROBE( ftran__return );
+MARABOU_DECLARE_PROBE( btran__entry );
+MARABOU_DECLARE_PROBE( btran__return );
+MARABOU_DECLARE_PROBE( bound__tighten );
+MARABOU_DECLARE_PROBE( variable__eliminate );
+MARABOU_DECLARE_PROBE( eliminate__begin );
+
+#else
+
+// The arguments are not evaluated
+#define MARABOU_PROBE_ENABLED( name ) false
+#define MARABOU_PROBE1( name, a ) do { (void)sizeof( a ); } while ( 0 )
+#define MARABOU_PROBE2( name, a, b ) do { (void)sizeof( a ); (void)sizeof( b ); } while ( 0 )
+#define MARABOU_PROBE3( name, a, b, c ) do { (void)sizeof( a ); (void)sizeof( b ); (void)sizeof( c ); } while ( 0 )
+
+#endif // MARABOU_PROBES_ENABLED
+
+namespace Probes
+{
+    /*
+      The raw bits of a double, for passing it to a probe.
+    */
+    inline unsigned long long bits( double value )
+    {
+        unsigned long long result;
+        memcpy( &result, &value, sizeof(result) );
+        return result;
+    }
+}
+
+#endif // __Probes_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
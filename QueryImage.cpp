@@ -0,0 +1,593 @@
+/*********************                                                        */
+/*! \file QueryImage.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "CommonError.h"
+#include "HashUtils.h"
+#include "InputQuery.h"
+#include "MStringf.h"
+#include "Preprocessor.h"
+#include "QueryImage.h"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    const uint32_t IMAGE_MAGIC = 0x49514d4d; // "MMQI"
+    const uint32_t IMAGE_VERSION = 2;
+    const uint32_t IMAGE_BYTE_ORDER_MARK = 0x01020304;
+    const uint64_t IMAGE_ALIGNMENT = 64;
+
+    enum Section {
+        LOWER_BOUNDS = 0,
+        UPPER_BOUNDS,
+        EQUATION_START,
+        ADDEND_VARIABLES,
+        ADDEND_COEFFICIENTS,
+        EQUATION_SCALARS,
+        AUXILIARY_VARIABLES,
+        CONSTRAINT_KINDS,
+        CONSTRAINT_ACTIVE,
+        CONSTRAINT_START,
+        CONSTRAINT_VARIABLES,
+        OLD_INDEX_TO_NEW_INDEX,
+        FIXED_VALUES,
+
+        NUM_SECTIONS,
+    };
+
+    uint64_t alignUp( uint64_t offset )
+    {
+        return ( offset + IMAGE_ALIGNMENT - 1 ) & ~( IMAGE_ALIGNMENT - 1 );
+    }
+
+    /*
+      Check that the start offsets of a compressed sparse row array with
+      the given number of rows begin at 0, never decrease, and end at
+      the number of entries.
+    */
+    bool isValidRowStart( const ArrayView<uint64_t> &start, uint64_t numberOfEntries )
+    {
+        if ( ( start[0] != 0 ) || ( start[start.size() - 1] != numberOfEntries ) )
+            return false;
+
+        for ( uint64_t i = 1; i < start.size(); ++i )
+        {
+            if ( start[i] < start[i - 1] )
+                return false;
+        }
+
+        return true;
+    }
+
+    /*
+      Check that all the variable indices in an array are below a
+      limit, optionally allowing for ELIMINATED.
+    */
+    bool areValidVariables( const ArrayView<uint32_t> &variables, uint64_t limit, bool allowEliminated = false )
+    {
+        for ( uint32_t variable : variables )
+        {
+            if ( variable < limit )
+                continue;
+
+            if ( !allowEliminated || ( variable != QueryImage::ELIMINATED ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    bool areValidKinds( const ArrayView<uint32_t> &kinds )
+    {
+        for ( uint32_t kind : kinds )
+        {
+            if ( !ConstraintKind::isValid( kind ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    /*
+      Writes the image sequentially, keeping track of the offset and of
+      the checksum of everything written after the header.
+    */
+    class ImageWriter
+    {
+    public:
+        ImageWriter( FILE *file )
+            : _file( file )
+            , _offset( 0 )
+            , _checksum( HashUtils::FNV_OFFSET_BASIS )
+            , _hashing( false )
+        {
+        }
+
+        void write( const void *data, uint64_t size )
+        {
+            if ( size == 0 )
+                return;
+
+            if ( fwrite( data, 1, size, _file ) != size )
+                throw CommonError( CommonError::WRITE_FAILED, "QueryImage" );
+
+            if ( _hashing )
+                _checksum = HashUtils::hash( data, size, _checksum );
+
+            _offset += size;
+        }
+
+        void align()
+        {
+            static const char zeros[IMAGE_ALIGNMENT] = { 0 };
+            write( zeros, alignUp( _offset ) - _offset );
+        }
+
+        template<typename T>
+        void writeSection( const std::vector<T> &data, uint64_t &offset, uint64_t &size )
+        {
+            align();
+            offset = _offset;
+            size = sizeof(T) * data.size();
+            write( data.data(), size );
+        }
+
+        FILE *_file;
+        uint64_t _offset;
+        uint64_t _checksum;
+        bool _hashing;
+    };
+}
+
+struct QueryImage::Header
+{
+    uint32_t _magic;
+    uint32_t _version;
+    uint32_t _byteOrderMark;
+    uint32_t _headerSize;
+    uint32_t _constraintKindVersion;
+    uint32_t _reserved;
+
+    uint64_t _numberOfVariables;
+    uint64_t _numberOfOriginalVariables;
+    uint64_t _numberOfEquations;
+    uint64_t _numberOfAddends;
+    uint64_t _numberOfConstraints;
+    uint64_t _numberOfConstraintVariables;
+
+    uint64_t _fileSize;
+    uint64_t _payloadChecksum;
+
+    uint64_t _sectionOffset[NUM_SECTIONS];
+    uint64_t _sectionSize[NUM_SECTIONS];
+};
+
+QueryImage::QueryImage()
+    : _mapping( NULL )
+    , _mappingSize( 0 )
+    , _header( NULL )
+{
+}
+
+QueryImage::~QueryImage()
+{
+    close();
+}
+
+void QueryImage::write( const String &path,
+                        const InputQuery &preprocessed,
+                        const Preprocessor &preprocessor,
+                        unsigned numberOfOriginalVariables )
+{
+    Header header;
+    memset( &header, 0, sizeof(header) );
+    header._magic = IMAGE_MAGIC;
+    header._version = IMAGE_VERSION;
+    header._byteOrderMark = IMAGE_BYTE_ORDER_MARK;
+    header._headerSize = sizeof(Header);
+    header._constraintKindVersion = ConstraintKind::VERSION;
+
+    unsigned n = preprocessed.getNumberOfVariables();
+    header._numberOfVariables = n;
+    header._numberOfOriginalVariables = numberOfOriginalVariables;
+
+    // Write to a temporary file and rename it, so that a reader that
+    // maps the image never sees a partial or truncated file
+    String temporaryPath = path + Stringf( ".%u.tmp", (unsigned)getpid() );
+
+    FILE *file = fopen( temporaryPath.ascii(), "wb" );
+    if ( !file )
+        throw CommonError( CommonError::OPEN_FAILED, temporaryPath.ascii() );
+
+    try
+    {
+        ImageWriter writer( file );
+
+        // Reserve room for the header, which is rewritten at the end
+        writer.write( &header, sizeof(header) );
+        writer._hashing = true;
+
+        // Bounds
+        std::vector<double> lowerBounds( n );
+        std::vector<double> upperBounds( n );
+        for ( unsigned i = 0; i < n; ++i )
+        {
+            lowerBounds[i] = preprocessed.getLowerBound( i );
+            upperBounds[i] = preprocessed.getUpperBound( i );
+        }
+        writer.writeSection( lowerBounds, header._sectionOffset[LOWER_BOUNDS], header._sectionSize[LOWER_BOUNDS] );
+        writer.writeSection( upperBounds, header._sectionOffset[UPPER_BOUNDS], header._sectionSize[UPPER_BOUNDS] );
+
+        // Equations
+        std::vector<uint64_t> equationStart;
+        std::vector<uint32_t> addendVariables;
+        std::vector<double> addendCoefficients;
+        std::vector<double> scalars;
+        std::vector<uint32_t> auxiliaryVariables;
+
+        for ( const auto &equation : preprocessed.getEquations() )
+        {
+            equationStart.push_back( addendVariables.size() );
+            for ( const auto &addend : equation._addends )
+            {
+                addendVariables.push_back( addend._variable );
+                addendCoefficients.push_back( addend._coefficient );
+            }
+
+            scalars.push_back( equation._scalar );
+            auxiliaryVariables.push_back( equation._auxVariable );
+        }
+        equationStart.push_back( addendVariables.size() );
+
+        header._numberOfEquations = scalars.size();
+        header._numberOfAddends = addendVariables.size();
+
+        writer.writeSection( equationStart, header._sectionOffset[EQUATION_START], header._sectionSize[EQUATION_START] );
+        writer.writeSection( addendVariables, header._sectionOffset[ADDEND_VARIABLES], header._sectionSize[ADDEND_VARIABLES] );
+        writer.writeSection( addendCoefficients, header._sectionOffset[ADDEND_COEFFICIENTS], header._sectionSize[ADDEND_COEFFICIENTS] );
+        writer.writeSection( scalars, header._sectionOffset[EQUATION_SCALARS], header._sectionSize[EQUATION_SCALARS] );
+        writer.writeSection( auxiliaryVariables, header._sectionOffset[AUXILIARY_VARIABLES], header._sectionSize[AUXILIARY_VARIABLES] );
+
+        // Piecewise linear constraint descriptors
+        std::vector<uint32_t> kinds;
+        std::vector<uint32_t> active;
+        std::vector<uint64_t> constraintStart;
+        std::vector<uint32_t> constraintVariables;
+
+        for ( const auto &constraint : preprocessed.getPiecewiseLinearConstraints() )
+        {
+            ConstraintKind::Kind kind = ConstraintKind::of( constraint );
+            if ( kind == ConstraintKind::UNKNOWN )
+                throw CommonError( CommonError::WRITE_FAILED, "QueryImage: constraint of unknown kind" );
+
+            kinds.push_back( kind );
+            active.push_back( constraint->isActive() );
+            constraintStart.push_back( constraintVariables.size() );
+            for ( unsigned variable : constraint->getParticipatingVariables() )
+                constraintVariables.push_back( variable );
+        }
+        constraintStart.push_back( constraintVariables.size() );
+
+        header._numberOfConstraints = kinds.size();
+        header._numberOfConstraintVariables = constraintVariables.size();
+
+        writer.writeSection( kinds, header._sectionOffset[CONSTRAINT_KINDS], header._sectionSize[CONSTRAINT_KINDS] );
+        writer.writeSection( active, header._sectionOffset[CONSTRAINT_ACTIVE], header._sectionSize[CONSTRAINT_ACTIVE] );
+        writer.writeSection( constraintStart, header._sectionOffset[CONSTRAINT_START], header._sectionSize[CONSTRAINT_START] );
+        writer.writeSection( constraintVariables, header._sectionOffset[CONSTRAINT_VARIABLES], header._sectionSize[CONSTRAINT_VARIABLES] );
+
+        // Index maps
+        std::vector<uint32_t> oldIndexToNewIndex( numberOfOriginalVariables );
+        std::vector<double> fixedValues( numberOfOriginalVariables, 0.0 );
+        for ( unsigned i = 0; i < numberOfOriginalVariables; ++i )
+        {
+            if ( preprocessor.variableIsFixed( i ) )
+            {
+                oldIndexToNewIndex[i] = ELIMINATED;
+                fixedValues[i] = preprocessor.getFixedValue( i );
+            }
+            else
+            {
+                oldIndexToNewIndex[i] = preprocessor.getNewIndex( i );
+            }
+        }
+
+        writer.writeSection( oldIndexToNewIndex, header._sectionOffset[OLD_INDEX_TO_NEW_INDEX], header._sectionSize[OLD_INDEX_TO_NEW_INDEX] );
+        writer.writeSection( fixedValues, header._sectionOffset[FIXED_VALUES], header._sectionSize[FIXED_VALUES] );
+        writer.align();
+
+        header._fileSize = writer._offset;
+        header._payloadChecksum = writer._checksum;
+
+        if ( ( fseek( file, 0, SEEK_SET ) != 0 ) || ( fwrite( &header, sizeof(header), 1, file ) != 1 ) )
+            throw CommonError( CommonError::WRITE_FAILED, temporaryPath.ascii() );
+    }
+    catch ( ... )
+    {
+        fclose( file );
+        unlink( temporaryPath.ascii() );
+        throw;
+    }
+
+    if ( fclose( file ) != 0 )
+    {
+        unlink( temporaryPath.ascii() );
+        throw CommonError( CommonError::WRITE_FAILED, temporaryPath.ascii() );
+    }
+
+    if ( rename( temporaryPath.ascii(), path.ascii() ) != 0 )
+    {
+        unlink( temporaryPath.ascii() );
+        throw CommonError( CommonError::WRITE_FAILED, path.ascii() );
+    }
+}
+
+void QueryImage::open( const String &path, bool verifyChecksum )
+{
+    close();
+
+    int descriptor = ::open( path.ascii(), O_RDONLY );
+    if ( descriptor < 0 )
+        throw CommonError( CommonError::OPEN_FAILED, path.ascii() );
+
+    struct stat fileStatus;
+    if ( fstat( descriptor, &fileStatus ) != 0 || ( (uint64_t)fileStatus.st_size < sizeof(Header) ) )
+    {
+        ::close( descriptor );
+        throw CommonError( CommonError::READ_FAILED, "QueryImage: file too small" );
+    }
+
+    void *mapping = mmap( NULL, fileStatus.st_size, PROT_READ, MAP_SHARED, descriptor, 0 );
+    ::close( descriptor );
+
+    if ( mapping == MAP_FAILED )
+        throw CommonError( CommonError::READ_FAILED, "QueryImage: mmap failed" );
+
+    _mapping = mapping;
+    _mappingSize = fileStatus.st_size;
+    _header = (const Header *)_mapping;
+
+    // Validate the header and the section layout
+    bool valid =
+        ( _header->_magic == IMAGE_MAGIC ) &&
+        ( _header->_version == IMAGE_VERSION ) &&
+        ( _header->_byteOrderMark == IMAGE_BYTE_ORDER_MARK ) &&
+        ( _header->_headerSize == sizeof(Header) ) &&
+        ( _header->_constraintKindVersion == ConstraintKind::VERSION ) &&
+        ( _header->_fileSize == _mappingSize );
+
+    // Every count is bounded by the file size, so that the expected
+    // section sizes cannot overflow. Variable indices are 32 bits wide.
+    valid = valid &&
+        ( _header->_numberOfVariables < ELIMINATED ) &&
+        ( _header->_numberOfOriginalVariables <= _mappingSize ) &&
+        ( _header->_numberOfEquations <= _mappingSize ) &&
+        ( _header->_numberOfAddends <= _mappingSize ) &&
+        ( _header->_numberOfConstraints <= _mappingSize ) &&
+        ( _header->_numberOfConstraintVariables <= _mappingSize );
+
+    uint64_t expectedSize[NUM_SECTIONS];
+    expectedSize[LOWER_BOUNDS] = sizeof(double) * _header->_numberOfVariables;
+    expectedSize[UPPER_BOUNDS] = sizeof(double) * _header->_numberOfVariables;
+    expectedSize[EQUATION_START] = sizeof(uint64_t) * ( _header->_numberOfEquations + 1 );
+    expectedSize[ADDEND_VARIABLES] = sizeof(uint32_t) * _header->_numberOfAddends;
+    expectedSize[ADDEND_COEFFICIENTS] = sizeof(double) * _header->_numberOfAddends;
+    expectedSize[EQUATION_SCALARS] = sizeof(double) * _header->_numberOfEquations;
+    expectedSize[AUXILIARY_VARIABLES] = sizeof(uint32_t) * _header->_numberOfEquations;
+    expectedSize[CONSTRAINT_KINDS] = sizeof(uint32_t) * _header->_numberOfConstraints;
+    expectedSize[CONSTRAINT_ACTIVE] = sizeof(uint32_t) * _header->_numberOfConstraints;
+    expectedSize[CONSTRAINT_START] = sizeof(uint64_t) * ( _header->_numberOfConstraints + 1 );
+    expectedSize[CONSTRAINT_VARIABLES] = sizeof(uint32_t) * _header->_numberOfConstraintVariables;
+    expectedSize[OLD_INDEX_TO_NEW_INDEX] = sizeof(uint32_t) * _header->_numberOfOriginalVariables;
+    expectedSize[FIXED_VALUES] = sizeof(double) * _header->_numberOfOriginalVariables;
+
+    for ( unsigned i = 0; valid && i < NUM_SECTIONS; ++i )
+    {
+        uint64_t offset = _header->_sectionOffset[i];
+        uint64_t size = _header->_sectionSize[i];
+
+        valid =
+            ( size == expectedSize[i] ) &&
+            ( offset % IMAGE_ALIGNMENT == 0 ) &&
+            ( offset >= sizeof(Header) ) &&
+            ( offset <= _mappingSize ) &&
+            ( size <= _mappingSize - offset );
+    }
+
+    // The accessors and toInputQuery() index with the contents of the
+    // sections, so these are checked too. This is linear in the size
+    // of the query, and much cheaper than the checksum.
+    if ( valid )
+        valid = contentsAreValid();
+
+    if ( valid && verifyChecksum )
+    {
+        const char *payload = (const char *)_mapping + sizeof(Header);
+        valid = ( HashUtils::hash( payload, _mappingSize - sizeof(Header) ) == _header->_payloadChecksum );
+    }
+
+    if ( !valid )
+    {
+        close();
+        throw CommonError( CommonError::READ_FAILED, "QueryImage: invalid image" );
+    }
+}
+
+bool QueryImage::contentsAreValid() const
+{
+    uint64_t n = _header->_numberOfVariables;
+
+    return
+        isValidRowStart( getEquationStart(), _header->_numberOfAddends ) &&
+        isValidRowStart( section<uint64_t>( CONSTRAINT_START, _header->_numberOfConstraints + 1 ),
+                         _header->_numberOfConstraintVariables ) &&
+        areValidVariables( getAddendVariables(), n ) &&
+        areValidVariables( getAuxiliaryVariables(), n ) &&
+        areValidVariables( section<uint32_t>( CONSTRAINT_VARIABLES, _header->_numberOfConstraintVariables ), n ) &&
+        areValidVariables( getOldIndexToNewIndex(), n, true ) &&
+        areValidKinds( section<uint32_t>( CONSTRAINT_KINDS, _header->_numberOfConstraints ) );
+}
+
+void QueryImage::close()
+{
+    if ( _mapping )
+    {
+        munmap( _mapping, _mappingSize );
+        _mapping = NULL;
+        _mappingSize = 0;
+        _header = NULL;
+    }
+}
+
+template<typename T>
+ArrayView<T> QueryImage::section( unsigned index, uint64_t size ) const
+{
+    ASSERT( _header );
+    return ArrayView<T>( (const T *)( (const char *)_mapping + _header->_sectionOffset[index] ), size );
+}
+
+unsigned QueryImage::getNumberOfVariables() const
+{
+    return _header->_numberOfVariables;
+}
+
+unsigned QueryImage::getNumberOfOriginalVariables() const
+{
+    return _header->_numberOfOriginalVariables;
+}
+
+unsigned QueryImage::getNumberOfEquations() const
+{
+    return _header->_numberOfEquations;
+}
+
+unsigned QueryImage::getNumberOfConstraints() const
+{
+    return _header->_numberOfConstraints;
+}
+
+ArrayView<double> QueryImage::getLowerBounds() const
+{
+    return section<double>( LOWER_BOUNDS, _header->_numberOfVariables );
+}
+
+ArrayView<double> QueryImage::getUpperBounds() const
+{
+    return section<double>( UPPER_BOUNDS, _header->_numberOfVariables );
+}
+
+ArrayView<uint64_t> QueryImage::getEquationStart() const
+{
+    return section<uint64_t>( EQUATION_START, _header->_numberOfEquations + 1 );
+}
+
+ArrayView<uint32_t> QueryImage::getAddendVariables() const
+{
+    return section<uint32_t>( ADDEND_VARIABLES, _header->_numberOfAddends );
+}
+
+ArrayView<double> QueryImage::getAddendCoefficients() const
+{
+    return section<double>( ADDEND_COEFFICIENTS, _header->_numberOfAddends );
+}
+
+ArrayView<double> QueryImage::getEquationScalars() const
+{
+    return section<double>( EQUATION_SCALARS, _header->_numberOfEquations );
+}
+
+ArrayView<uint32_t> QueryImage::getAuxiliaryVariables() const
+{
+    return section<uint32_t>( AUXILIARY_VARIABLES, _header->_numberOfEquations );
+}
+
+ConstraintKind::Kind QueryImage::getConstraintKind( unsigned constraint ) const
+{
+    return (ConstraintKind::Kind)section<uint32_t>( CONSTRAINT_KINDS, _header->_numberOfConstraints )[constraint];
+}
+
+bool QueryImage::constraintIsActive( unsigned constraint ) const
+{
+    return section<uint32_t>( CONSTRAINT_ACTIVE, _header->_numberOfConstraints )[constraint] != 0;
+}
+
+ArrayView<uint32_t> QueryImage::getConstraintVariables( unsigned constraint ) const
+{
+    ArrayView<uint64_t> start = section<uint64_t>( CONSTRAINT_START, _header->_numberOfConstraints + 1 );
+    ArrayView<uint32_t> variables = section<uint32_t>( CONSTRAINT_VARIABLES, _header->_numberOfConstraintVariables );
+    return variables.slice( start[constraint], start[constraint + 1] - start[constraint] );
+}
+
+ArrayView<uint32_t> QueryImage::getOldIndexToNewIndex() const
+{
+    return section<uint32_t>( OLD_INDEX_TO_NEW_INDEX, _header->_numberOfOriginalVariables );
+}
+
+ArrayView<double> QueryImage::getFixedValues() const
+{
+    return section<double>( FIXED_VALUES, _header->_numberOfOriginalVariables );
+}
+
+void QueryImage::toInputQuery( InputQuery &query, ConstraintFactory &factory ) const
+{
+    unsigned n = getNumberOfVariables();
+    query.setNumberOfVariables( n );
+
+    ArrayView<double> lowerBounds = getLowerBounds();
+    ArrayView<double> upperBounds = getUpperBounds();
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        query.setLowerBound( i, lowerBounds[i] );
+        query.setUpperBound( i, upperBounds[i] );
+    }
+
+    ArrayView<uint64_t> equationStart = getEquationStart();
+    ArrayView<uint32_t> addendVariables = getAddendVariables();
+    ArrayView<double> addendCoefficients = getAddendCoefficients();
+    ArrayView<double> scalars = getEquationScalars();
+    ArrayView<uint32_t> auxiliaryVariables = getAuxiliaryVariables();
+
+    for ( unsigned i = 0; i < getNumberOfEquations(); ++i )
+    {
+        Equation equation;
+        for ( uint64_t j = equationStart[i]; j < equationStart[i + 1]; ++j )
+            equation.addAddend( addendCoefficients[j], addendVariables[j] );
+
+        equation.setScalar( scalars[i] );
+        equation.markAuxiliaryVariable( auxiliaryVariables[i] );
+        query.addEquation( equation );
+    }
+
+    for ( unsigned i = 0; i < getNumberOfConstraints(); ++i )
+    {
+        PiecewiseLinearConstraint *constraint =
+            factory.createConstraint( getConstraintKind( i ), getConstraintVariables( i ) );
+
+        if ( !constraintIsActive( i ) )
+            constraint->setActiveConstraint( false );
+
+        query.addPiecewiseLinearConstraint( constraint );
+    }
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,141 @@
+/*********************                                                        */
+/*! \file QueryImage.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __QueryImage_h__
+#define __QueryImage_h__
+
+#include "ArrayView.h"
+#include "ConstraintKind.h"
+#include "MString.h"
+
+#include <stdint.h>
+
+class InputQuery;
+class PiecewiseLinearConstraint;
+class Preprocessor;
+
+/*
+  A versioned binary image of a preprocessed query, laid out so that it
+  can be used directly from a read-only memory mapping. The image holds:
+
+    - The variable bounds, as two dense arrays.
+    - The equations in compressed sparse row form: for equation i, its
+      addends are entries [equationStart[i], equationStart[i+1]) of the
+      addend variable and coefficient arrays.
+    - One descriptor per piecewise linear constraint: its kind (see
+      ConstraintKind, whose version is recorded in the header), an
+      active flag, and its participating variables (again in
+      compressed sparse row form).
+    - The preprocessor's maps over the original variables: the new
+      index of each variable (ELIMINATED if it was fixed), and the
+      value of each fixed variable.
+
+  Every section starts on a cache line boundary. Opening an image maps
+  it and validates its layout and indices; the accessors return views
+  into the mapping, so the pages are shared between all the processes
+  that map the same file.
+*/
+class QueryImage
+{
+public:
+    enum {
+        ELIMINATED = 0xFFFFFFFF,
+    };
+
+    /*
+      Constructs piecewise linear constraints from their descriptors
+      when an image is turned back into an input query.
+    */
+    class ConstraintFactory
+    {
+    public:
+        virtual ~ConstraintFactory() {}
+        virtual PiecewiseLinearConstraint *createConstraint( ConstraintKind::Kind kind,
+                                                             const ArrayView<uint32_t> &variables ) = 0;
+    };
+
+    QueryImage();
+    ~QueryImage();
+
+    /*
+      Write an image of a preprocessed query. The preprocessor is the
+      one that produced the query from a query with
+      numberOfOriginalVariables variables. All the constraints must be
+      of known kinds. The image is written to a temporary file and
+      renamed into place, so an existing image is replaced atomically.
+    */
+    static void write( const String &path,
+                       const InputQuery &preprocessed,
+                       const Preprocessor &preprocessor,
+                       unsigned numberOfOriginalVariables );
+
+    /*
+      Map an image. The header, the section layout, and the row offsets,
+      variable indices and constraint kinds in the sections are always
+      checked, so that the accessors stay within the mapping; checking
+      the payload checksum requires reading the whole file and is
+      optional.
+    */
+    void open( const String &path, bool verifyChecksum = false );
+    void close();
+
+    /*
+      Views of the image's contents.
+    */
+    unsigned getNumberOfVariables() const;
+    unsigned getNumberOfOriginalVariables() const;
+    unsigned getNumberOfEquations() const;
+    unsigned getNumberOfConstraints() const;
+
+    ArrayView<double> getLowerBounds() const;
+    ArrayView<double> getUpperBounds() const;
+
+    ArrayView<uint64_t> getEquationStart() const;
+    ArrayView<uint32_t> getAddendVariables() const;
+    ArrayView<double> getAddendCoefficients() const;
+    ArrayView<double> getEquationScalars() const;
+    ArrayView<uint32_t> getAuxiliaryVariables() const;
+
+    ConstraintKind::Kind getConstraintKind( unsigned constraint ) const;
+    bool constraintIsActive( unsigned constraint ) const;
+    ArrayView<uint32_t> getConstraintVariables( unsigned constraint ) const;
+
+    ArrayView<uint32_t> getOldIndexToNewIndex() const;
+    ArrayView<double> getFixedValues() const;
+
+    /*
+      Rebuild an input query from the image.
+    */
+    void toInputQuery( InputQuery &query, ConstraintFactory &factory ) const;
+
+private:
+    struct Header;
+
+    void *_mapping;
+    uint64_t _mappingSize;
+    const Header *_header;
+
+    template<typename T>
+    ArrayView<T> section( unsigned index, uint64_t size ) const;
+
+    bool contentsAreValid() const;
+};
+
+#endif // __QueryImage_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,349 @@
+/*********************                                                        */
+/*! \file SharedBoundDatabase.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "BoundStore.h"
+#include "Debug.h"
+#include "FloatUtils.h"
+#include "InputQuery.h"
+#include "ReluplexError.h"
+#include "Set.h"
+#include "SharedBoundDatabase.h"
+
+SharedBoundDatabase::Subscriber::Subscriber()
+    : _nextSequence( 0 )
+    , _fullScan( true )
+{
+}
+
+void SharedBoundDatabase::Subscriber::requestFullScan()
+{
+    _fullScan = true;
+}
+
+SharedBoundDatabase::SharedBoundDatabase( unsigned n, unsigned logCapacity )
+    : _n( n )
+    , _lowerBounds( NULL )
+    , _upperBounds( NULL )
+    , _log( NULL )
+    , _logMask( 0 )
+    , _head( 0 )
+    , _infeasible( false )
+    , _numTightenings( 0 )
+    , _numFullScans( 0 )
+{
+    allocate( logCapacity );
+
+    for ( unsigned i = 0; i < _n; ++i )
+    {
+        _lowerBounds[i].store( FloatUtils::negativeInfinity(), std::memory_order_relaxed );
+        _upperBounds[i].store( FloatUtils::infinity(), std::memory_order_relaxed );
+    }
+}
+
+SharedBoundDatabase::SharedBoundDatabase( const InputQuery &query, unsigned logCapacity )
+    : _n( query.getNumberOfVariables() )
+    , _lowerBounds( NULL )
+    , _upperBounds( NULL )
+    , _log( NULL )
+    , _logMask( 0 )
+    , _head( 0 )
+    , _infeasible( false )
+    , _numTightenings( 0 )
+    , _numFullScans( 0 )
+{
+    allocate( logCapacity );
+
+    for ( unsigned i = 0; i < _n; ++i )
+    {
+        _lowerBounds[i].store( query.getLowerBound( i ), std::memory_order_relaxed );
+        _upperBounds[i].store( query.getUpperBound( i ), std::memory_order_relaxed );
+    }
+}
+
+SharedBoundDatabase::~SharedBoundDatabase()
+{
+    freeIfNeeded();
+}
+
+void SharedBoundDatabase::allocate( unsigned logCapacity )
+{
+    _lowerBounds = new std::atomic<double>[_n];
+    if ( !_lowerBounds )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "SharedBoundDatabase::lowerBounds" );
+
+    _upperBounds = new std::atomic<double>[_n];
+    if ( !_upperBounds )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "SharedBoundDatabase::upperBounds" );
+
+    unsigned capacity = 1;
+    while ( capacity < logCapacity )
+        capacity <<= 1;
+    _logMask = capacity - 1;
+
+    _log = new LogEntry[capacity];
+    if ( !_log )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "SharedBoundDatabase::log" );
+
+    for ( unsigned i = 0; i < capacity; ++i )
+    {
+        _log[i]._sequence.store( 0, std::memory_order_relaxed );
+        _log[i]._code.store( 0, std::memory_order_relaxed );
+    }
+}
+
+void SharedBoundDatabase::freeIfNeeded()
+{
+    if ( _lowerBounds )
+    {
+        delete[] _lowerBounds;
+        _lowerBounds = NULL;
+    }
+
+    if ( _upperBounds )
+    {
+        delete[] _upperBounds;
+        _upperBounds = NULL;
+    }
+
+    if ( _log )
+    {
+        delete[] _log;
+        _log = NULL;
+    }
+}
+
+unsigned SharedBoundDatabase::getNumberOfVariables() const
+{
+    return _n;
+}
+
+bool SharedBoundDatabase::tightenLowerBound( unsigned variable, double value )
+{
+    ASSERT( variable < _n );
+
+    double current = _lowerBounds[variable].load( std::memory_order_relaxed );
+    while ( FloatUtils::gt( value, current ) )
+    {
+        // On failure, current is reloaded with the competing value
+        if ( _lowerBounds[variable].compare_exchange_weak( current,
+                                                           value,
+                                                           std::memory_order_release,
+                                                           std::memory_order_relaxed ) )
+        {
+            ++_numTightenings;
+            append( variable, false );
+            checkFeasibility( variable );
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool SharedBoundDatabase::tightenUpperBound( unsigned variable, double value )
+{
+    ASSERT( variable < _n );
+
+    double current = _upperBounds[variable].load( std::memory_order_relaxed );
+    while ( FloatUtils::lt( value, current ) )
+    {
+        if ( _upperBounds[variable].compare_exchange_weak( current,
+                                                           value,
+                                                           std::memory_order_release,
+                                                           std::memory_order_relaxed ) )
+        {
+            ++_numTightenings;
+            append( variable, true );
+            checkFeasibility( variable );
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SharedBoundDatabase::append( unsigned variable, bool upper )
+{
+    unsigned long long sequence = _head.fetch_add( 1, std::memory_order_relaxed );
+    LogEntry &entry = _log[sequence & _logMask];
+
+    // Invalidate the slot while the code is being replaced
+    entry._sequence.store( 0, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    entry._code.store( ( variable << 1 ) | ( upper ? 1 : 0 ), std::memory_order_relaxed );
+    entry._sequence.store( sequence + 1, std::memory_order_release );
+}
+
+void SharedBoundDatabase::checkFeasibility( unsigned variable )
+{
+    if ( FloatUtils::gt( _lowerBounds[variable].load( std::memory_order_acquire ),
+                         _upperBounds[variable].load( std::memory_order_acquire ) ) )
+        _infeasible.store( true, std::memory_order_release );
+}
+
+unsigned SharedBoundDatabase::publishBounds( const BoundStore &store )
+{
+    ASSERT( store.getNumberOfVariables() == _n );
+
+    unsigned improved = 0;
+    for ( unsigned i = 0; i < _n; ++i )
+    {
+        if ( tightenLowerBound( i, store.getLowerBound( i ) ) )
+            ++improved;
+        if ( tightenUpperBound( i, store.getUpperBound( i ) ) )
+            ++improved;
+    }
+
+    return improved;
+}
+
+double SharedBoundDatabase::getLowerBound( unsigned variable ) const
+{
+    ASSERT( variable < _n );
+    return _lowerBounds[variable].load( std::memory_order_acquire );
+}
+
+double SharedBoundDatabase::getUpperBound( unsigned variable ) const
+{
+    ASSERT( variable < _n );
+    return _upperBounds[variable].load( std::memory_order_acquire );
+}
+
+bool SharedBoundDatabase::isInfeasible() const
+{
+    return _infeasible.load( std::memory_order_acquire );
+}
+
+void SharedBoundDatabase::subscribe( Subscriber &subscriber ) const
+{
+    subscriber._nextSequence = _head.load( std::memory_order_acquire );
+    subscriber._fullScan = true;
+}
+
+void SharedBoundDatabase::addTightening( unsigned variable,
+                                         bool upper,
+                                         const BoundStore &store,
+                                         List<Tightening> &tightenings ) const
+{
+    if ( upper )
+    {
+        double value = getUpperBound( variable );
+        if ( FloatUtils::lt( value, store.getUpperBound( variable ) ) )
+            tightenings.append( Tightening( variable, value, Tightening::UB ) );
+    }
+    else
+    {
+        double value = getLowerBound( variable );
+        if ( FloatUtils::gt( value, store.getLowerBound( variable ) ) )
+            tightenings.append( Tightening( variable, value, Tightening::LB ) );
+    }
+}
+
+void SharedBoundDatabase::scanAll( const BoundStore &store, List<Tightening> &tightenings ) const
+{
+    ++_numFullScans;
+
+    for ( unsigned i = 0; i < _n; ++i )
+    {
+        addTightening( i, false, store, tightenings );
+        addTightening( i, true, store, tightenings );
+    }
+}
+
+void SharedBoundDatabase::collectTightenings( Subscriber &subscriber,
+                                              const BoundStore &store,
+                                              List<Tightening> &tightenings ) const
+{
+    ASSERT( store.getNumberOfVariables() == _n );
+
+    unsigned long long head = _head.load( std::memory_order_acquire );
+
+    // Entries older than one log length have been overwritten
+    if ( head - subscriber._nextSequence > _logMask + 1 )
+        subscriber._fullScan = true;
+
+    if ( subscriber._fullScan )
+    {
+        // Anything logged from here on is seen by the next import
+        subscriber._nextSequence = head;
+        subscriber._fullScan = false;
+        scanAll( store, tightenings );
+        return;
+    }
+
+    Set<unsigned> seen;
+    unsigned long long sequence;
+    for ( sequence = subscriber._nextSequence; sequence < head; ++sequence )
+    {
+        const LogEntry &entry = _log[sequence & _logMask];
+
+        unsigned long long before = entry._sequence.load( std::memory_order_acquire );
+        unsigned code = entry._code.load( std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_acquire );
+        unsigned long long after = entry._sequence.load( std::memory_order_relaxed );
+
+        if ( before != after || before > sequence + 1 )
+        {
+            // The slot was overwritten by a newer entry
+            subscriber._nextSequence = head;
+            scanAll( store, tightenings );
+            return;
+        }
+
+        // The writer has reserved the slot but not filled it yet; resume
+        // from here next time
+        if ( before < sequence + 1 )
+            break;
+
+        if ( seen.exists( code ) )
+            continue;
+        seen.insert( code );
+
+        addTightening( code >> 1, code & 1, store, tightenings );
+    }
+
+    subscriber._nextSequence = sequence;
+}
+
+unsigned SharedBoundDatabase::importBounds( Subscriber &subscriber, BoundStore &store ) const
+{
+    List<Tightening> tightenings;
+    collectTightenings( subscriber, store, tightenings );
+
+    for ( const auto &tightening : tightenings )
+    {
+        if ( tightening._type == Tightening::LB )
+            store.setLowerBound( tightening._variable, tightening._value );
+        else
+            store.setUpperBound( tightening._variable, tightening._value );
+    }
+
+    return tightenings.size();
+}
+
+unsigned long long SharedBoundDatabase::getNumTightenings() const
+{
+    return _numTightenings.load( std::memory_order_relaxed );
+}
+
+unsigned long long SharedBoundDatabase::getNumFullScans() const
+{
+    return _numFullScans.load( std::memory_order_relaxed );
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,175 @@
+/*********************                                                        */
+/*! \file SharedBoundDatabase.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __SharedBoundDatabase_h__
+#define __SharedBoundDatabase_h__
+
+#include "List.h"
+#include "Tightening.h"
+
+#include <atomic>
+
+class BoundStore;
+class InputQuery;
+
+/*
+  Global variable bounds shared by concurrent workers that solve the
+  same (preprocessed) query, e.g. portfolio or split-and-conquer threads.
+
+  Bounds only ever get tighter. A worker publishes a tightening with a
+  compare-and-swap on the bound itself, so publishing never takes a
+  lock and never loosens a bound that another worker tightened
+  concurrently. Every successful tightening is also appended to a
+  fixed-size change log, which subscribers read at their own safe
+  points to import the improvements into their local bound store. A
+  subscriber that fell more than a full log behind simply rescans all
+  the bounds.
+
+  Only bounds that are valid for the whole query may be published, not
+  bounds that depend on the case splits of a particular worker.
+*/
+class SharedBoundDatabase
+{
+public:
+    enum {
+        DEFAULT_LOG_CAPACITY = 4096,
+    };
+
+    /*
+      A worker's position in the change log.
+    */
+    class Subscriber
+    {
+    public:
+        Subscriber();
+
+        /*
+          Make the next import compare all the bounds, e.g. after the
+          worker backtracked past the level at which earlier imports
+          were made.
+        */
+        void requestFullScan();
+
+    private:
+        friend class SharedBoundDatabase;
+
+        unsigned long long _nextSequence;
+        bool _fullScan;
+    };
+
+    /*
+      Create the database with unbounded variables, or with the bounds
+      of a query. The log capacity is rounded up to a power of two.
+    */
+    SharedBoundDatabase( unsigned n, unsigned logCapacity = DEFAULT_LOG_CAPACITY );
+    SharedBoundDatabase( const InputQuery &query, unsigned logCapacity = DEFAULT_LOG_CAPACITY );
+    ~SharedBoundDatabase();
+
+    /*
+      Free any allocated memory.
+    */
+    void freeIfNeeded();
+
+    unsigned getNumberOfVariables() const;
+
+    /*
+      Tighten a global bound. Returns true if this call improved it.
+      Safe to call from any thread.
+    */
+    bool tightenLowerBound( unsigned variable, double value );
+    bool tightenUpperBound( unsigned variable, double value );
+
+    /*
+      Publish all the bounds of a store, e.g. a worker's bounds at
+      decision level 0. Returns the number of improved bounds.
+    */
+    unsigned publishBounds( const BoundStore &store );
+
+    double getLowerBound( unsigned variable ) const;
+    double getUpperBound( unsigned variable ) const;
+
+    /*
+      Set once some variable's global lower bound exceeds its upper
+      bound, i.e. the query is infeasible and all workers may stop.
+    */
+    bool isInfeasible() const;
+
+    /*
+      Position a subscriber at the current end of the log. Its first
+      import compares all the bounds.
+    */
+    void subscribe( Subscriber &subscriber ) const;
+
+    /*
+      List the global bounds that are tighter than those of the given
+      store, among the bounds that changed since the subscriber's last
+      import, and advance the subscriber. The caller applies them, e.g.
+      through its propagator so that derived data stays in sync.
+    */
+    void collectTightenings( Subscriber &subscriber,
+                             const BoundStore &store,
+                             List<Tightening> &tightenings ) const;
+
+    /*
+      Like collectTightenings(), but apply the improvements directly to
+      the store. Returns the number of imported bounds. Imports made
+      above level 0 are undone when the store backtracks.
+    */
+    unsigned importBounds( Subscriber &subscriber, BoundStore &store ) const;
+
+    /*
+      Statistics
+    */
+    unsigned long long getNumTightenings() const;
+    unsigned long long getNumFullScans() const;
+
+private:
+    /*
+      A log slot. The sequence number is cleared while the slot is being
+      overwritten, so that a reader can tell whether the code it read
+      belongs to the sequence number it expected.
+    */
+    struct LogEntry
+    {
+        std::atomic<unsigned long long> _sequence;
+        std::atomic<unsigned> _code;
+    };
+
+    unsigned _n;
+    std::atomic<double> *_lowerBounds;
+    std::atomic<double> *_upperBounds;
+
+    LogEntry *_log;
+    unsigned _logMask;
+    std::atomic<unsigned long long> _head;
+
+    std::atomic<bool> _infeasible;
+
+    std::atomic<unsigned long long> _numTightenings;
+    mutable std::atomic<unsigned long long> _numFullScans;
+
+    void allocate( unsigned logCapacity );
+    void append( unsigned variable, bool upper );
+    void checkFeasibility( unsigned variable );
+    void scanAll( const BoundStore &store, List<Tightening> &tightenings ) const;
+    void addTightening( unsigned variable, bool upper, const BoundStore &store, List<Tightening> &tightenings ) const;
+};
+
+#endif // __SharedBoundDatabase_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
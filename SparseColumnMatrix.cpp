@@ -0,0 +1,150 @@
+/*********************                                                        */
+/*! \file SparseColumnMatrix.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "Debug.h"
+#include "ReluplexError.h"
+#include "SparseColumnMatrix.h"
+
+#include <cstring>
+
+SparseColumnMatrix::SparseColumnMatrix( unsigned m, unsigned n, const double *A )
+    : _m( m )
+    , _n( n )
+    , _columnStart( NULL )
+    , _rowIndices( NULL )
+    , _values( NULL )
+{
+    unsigned nonZeros = 0;
+    for ( unsigned i = 0; i < m * n; ++i )
+        if ( A[i] != 0.0 )
+            ++nonZeros;
+
+    allocate( nonZeros );
+
+    unsigned entry = 0;
+    for ( unsigned column = 0; column < n; ++column )
+    {
+        _columnStart[column] = entry;
+        for ( unsigned row = 0; row < m; ++row )
+        {
+            double value = A[row * n + column];
+            if ( value == 0.0 )
+                continue;
+
+            _rowIndices[entry] = row;
+            _values[entry] = value;
+            ++entry;
+        }
+    }
+    _columnStart[n] = entry;
+}
+
+SparseColumnMatrix::SparseColumnMatrix( unsigned m,
+                                        unsigned n,
+                                        const unsigned *columnStart,
+                                        const unsigned *rowIndices,
+                                        const double *values )
+    : _m( m )
+    , _n( n )
+    , _columnStart( NULL )
+    , _rowIndices( NULL )
+    , _values( NULL )
+{
+    allocate( columnStart[n] - columnStart[0] );
+
+    for ( unsigned column = 0; column <= n; ++column )
+        _columnStart[column] = columnStart[column] - columnStart[0];
+
+    memcpy( _rowIndices, rowIndices + columnStart[0], sizeof(unsigned) * _columnStart[n] );
+    memcpy( _values, values + columnStart[0], sizeof(double) * _columnStart[n] );
+
+    DEBUG({
+            for ( unsigned i = 0; i < _columnStart[n]; ++i )
+                ASSERT( _rowIndices[i] < _m );
+        });
+}
+
+SparseColumnMatrix::~SparseColumnMatrix()
+{
+    freeIfNeeded();
+}
+
+void SparseColumnMatrix::allocate( unsigned nonZeros )
+{
+    _columnStart = new unsigned[_n + 1];
+    if ( !_columnStart )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "SparseColumnMatrix::columnStart" );
+
+    _rowIndices = new unsigned[nonZeros];
+    if ( !_rowIndices )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "SparseColumnMatrix::rowIndices" );
+
+    _values = new double[nonZeros];
+    if ( !_values )
+        throw ReluplexError( ReluplexError::ALLOCATION_FAILED, "SparseColumnMatrix::values" );
+}
+
+void SparseColumnMatrix::freeIfNeeded()
+{
+    if ( _columnStart )
+    {
+        delete[] _columnStart;
+        _columnStart = NULL;
+    }
+
+    if ( _rowIndices )
+    {
+        delete[] _rowIndices;
+        _rowIndices = NULL;
+    }
+
+    if ( _values )
+    {
+        delete[] _values;
+        _values = NULL;
+    }
+}
+
+unsigned SparseColumnMatrix::getNumRows() const
+{
+    return _m;
+}
+
+unsigned SparseColumnMatrix::getNumColumns() const
+{
+    return _n;
+}
+
+unsigned SparseColumnMatrix::getNumNonZeros() const
+{
+    return _columnStart[_n];
+}
+
+unsigned SparseColumnMatrix::getColumn( unsigned column, unsigned *rowIndices, double *values ) const
+{
+    ASSERT( column < _n );
+
+    unsigned start = _columnStart[column];
+    unsigned count = _columnStart[column + 1] - start;
+
+    memcpy( rowIndices, _rowIndices + start, sizeof(unsigned) * count );
+    memcpy( values, _values + start, sizeof(double) * count );
+    return count;
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,79 @@
+/*********************                                                        */
+/*! \file SparseColumnMatrix.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __SparseColumnMatrix_h__
+#define __SparseColumnMatrix_h__
+
+/*
+  An m x n matrix, e.g. the constraint matrix, stored by columns in
+  compressed sparse column form. It is immutable once built, so it can
+  be shared by any number of basis factorizations, including ones used
+  by other threads.
+*/
+class SparseColumnMatrix
+{
+public:
+    /*
+      Build the matrix from a dense, row-major array, or copy it from
+      compressed sparse column form: the entries of column j are at
+      positions columnStart[j] up to columnStart[j + 1] of rowIndices
+      and values.
+    */
+    SparseColumnMatrix( unsigned m, unsigned n, const double *A );
+    SparseColumnMatrix( unsigned m,
+                        unsigned n,
+                        const unsigned *columnStart,
+                        const unsigned *rowIndices,
+                        const double *values );
+    ~SparseColumnMatrix();
+
+    /*
+      Free any allocated memory.
+    */
+    void freeIfNeeded();
+
+    unsigned getNumRows() const;
+    unsigned getNumColumns() const;
+    unsigned getNumNonZeros() const;
+
+    /*
+      Write the nonzero entries of a column as row indices and values,
+      into arrays of size m, and return their number.
+    */
+    unsigned getColumn( unsigned column, unsigned *rowIndices, double *values ) const;
+
+private:
+    unsigned _m;
+    unsigned _n;
+
+    unsigned *_columnStart;
+    unsigned *_rowIndices;
+    double *_values;
+
+    void allocate( unsigned nonZeros );
+
+    /*
+      Not copyable.
+    */
+    SparseColumnMatrix( const SparseColumnMatrix &other );
+    SparseColumnMatrix &operator=( const SparseColumnMatrix &other );
+};
+
+#endif // __SparseColumnMatrix_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
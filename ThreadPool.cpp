@@ -0,0 +1,116 @@
+/*********************                                                        */
+/*! \file ThreadPool.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool( unsigned numberOfThreads )
+    : _pending( 0 )
+    , _shuttingDown( false )
+{
+    if ( numberOfThreads == 0 )
+        numberOfThreads = std::thread::hardware_concurrency();
+
+    if ( numberOfThreads == 0 )
+        numberOfThreads = 1;
+
+    for ( unsigned i = 0; i < numberOfThreads; ++i )
+        _workers.push_back( std::thread( &ThreadPool::workerLoop, this ) );
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+        _shuttingDown = true;
+    }
+
+    _taskAvailable.notify_all();
+
+    for ( auto &worker : _workers )
+        worker.join();
+}
+
+void ThreadPool::submit( const Task &task )
+{
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+        _tasks.push( task );
+        ++_pending;
+    }
+
+    _taskAvailable.notify_one();
+}
+
+void ThreadPool::waitForAll()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    _allDone.wait( lock, [this]() { return _pending == 0; } );
+
+    if ( _error )
+    {
+        std::exception_ptr error = _error;
+        _error = nullptr;
+        std::rethrow_exception( error );
+    }
+}
+
+unsigned ThreadPool::getNumberOfThreads() const
+{
+    return _workers.size();
+}
+
+void ThreadPool::workerLoop()
+{
+    while ( true )
+    {
+        Task task;
+
+        {
+            std::unique_lock<std::mutex> lock( _mutex );
+            _taskAvailable.wait( lock, [this]() { return _shuttingDown || !_tasks.empty(); } );
+
+            if ( _tasks.empty() )
+                return;
+
+            task = _tasks.front();
+            _tasks.pop();
+        }
+
+        std::exception_ptr error;
+        try
+        {
+            task();
+        }
+        catch ( ... )
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::unique_lock<std::mutex> lock( _mutex );
+            if ( error && !_error )
+                _error = error;
+
+            --_pending;
+            if ( _pending == 0 )
+                _allDone.notify_all();
+        }
+    }
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
@@ -0,0 +1,83 @@
+/*********************                                                        */
+/*! \file ThreadPool.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __ThreadPool_h__
+#define __ThreadPool_h__
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/*
+  A fixed-size pool of worker threads that execute submitted tasks in
+  FIFO order.
+*/
+class ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    /*
+      Create the pool. A value of 0 means one thread per hardware
+      thread.
+    */
+    ThreadPool( unsigned numberOfThreads = 0 );
+    ~ThreadPool();
+
+    /*
+      Queue a task for execution.
+    */
+    void submit( const Task &task );
+
+    /*
+      Block until all submitted tasks have completed. If any of them
+      threw, the first exception is rethrown here (and cleared).
+    */
+    void waitForAll();
+
+    unsigned getNumberOfThreads() const;
+
+private:
+    std::vector<std::thread> _workers;
+    std::queue<Task> _tasks;
+
+    std::mutex _mutex;
+    std::condition_variable _taskAvailable;
+    std::condition_variable _allDone;
+
+    /*
+      Number of tasks that are queued or currently running.
+    */
+    unsigned _pending;
+    bool _shuttingDown;
+
+    /*
+      The first exception thrown by a task since the last wait.
+    */
+    std::exception_ptr _error;
+
+    void workerLoop();
+};
+
+#endif // __ThreadPool_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
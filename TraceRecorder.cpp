@@ -0,0 +1,411 @@
+/*********************                                                        */
+/*! \file TraceRecorder.cpp
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#include "CommonError.h"
+#include "List.h"
+#include "TraceRecorder.h"
+#include "Vector.h"
+
+#include <cstdio>
+#include <mutex>
+#include <unistd.h>
+
+std::atomic<bool> TraceRecorder::_enabled( false );
+
+namespace
+{
+    enum {
+        // The buffers of exited threads are kept for the dump, up to
+        // this many; older ones are freed
+        MAX_RETIRED_BUFFERS = 64,
+    };
+
+    std::atomic<unsigned> samplingRate( 1 );
+    std::atomic<unsigned> bufferCapacity( TraceRecorder::DEFAULT_BUFFER_CAPACITY );
+
+    /*
+      One event. The owning thread writes the fields between two updates
+      of the sequence number, which is odd while the slot is being
+      written, so that a concurrent reader can detect a torn event and
+      skip it.
+    */
+    struct Slot
+    {
+        std::atomic<unsigned long long> _sequence;
+        std::atomic<const char *> _name;
+        std::atomic<const char *> _category;
+        std::atomic<long long> _argument;
+        std::atomic<unsigned long long> _begin;
+        std::atomic<unsigned long long> _end;
+    };
+
+    struct Event
+    {
+        const char *_name;
+        const char *_category;
+        long long _argument;
+        unsigned long long _begin;
+        unsigned long long _end;
+    };
+
+    /*
+      The ring buffer of one thread. Only that thread writes into it.
+    */
+    struct ThreadBuffer
+    {
+        ThreadBuffer( unsigned threadId, unsigned capacity )
+            : _threadId( threadId )
+            , _mask( capacity - 1 )
+            , _slots( new Slot[capacity] )
+            , _next( 0 )
+            , _clearedAt( 0 )
+            , _sampleCounter( 0 )
+        {
+            for ( unsigned i = 0; i < capacity; ++i )
+                _slots[i]._sequence.store( 0, std::memory_order_relaxed );
+        }
+
+        ~ThreadBuffer()
+        {
+            if ( _slots )
+            {
+                delete[] _slots;
+                _slots = NULL;
+            }
+        }
+
+        void write( const char *name,
+                    const char *category,
+                    long long argument,
+                    unsigned long long begin,
+                    unsigned long long end )
+        {
+            unsigned long long index = _next.load( std::memory_order_relaxed );
+            Slot &slot( _slots[index & _mask] );
+
+            slot._sequence.store( 2 * index + 1, std::memory_order_relaxed );
+            std::atomic_thread_fence( std::memory_order_release );
+
+            slot._name.store( name, std::memory_order_relaxed );
+            slot._category.store( category, std::memory_order_relaxed );
+            slot._argument.store( argument, std::memory_order_relaxed );
+            slot._begin.store( begin, std::memory_order_relaxed );
+            slot._end.store( end, std::memory_order_relaxed );
+
+            slot._sequence.store( 2 * index + 2, std::memory_order_release );
+            _next.store( index + 1, std::memory_order_release );
+        }
+
+        /*
+          Copy out the events that are still in the buffer and were not
+          cleared, skipping any that are overwritten while reading.
+        */
+        void read( List<Event> &events ) const
+        {
+            unsigned long long end = _next.load( std::memory_order_acquire );
+            unsigned long long begin = _clearedAt.load( std::memory_order_relaxed );
+            if ( end > _mask + 1 && end - _mask - 1 > begin )
+                begin = end - _mask - 1;
+
+            for ( unsigned long long index = begin; index < end; ++index )
+            {
+                const Slot &slot( _slots[index & _mask] );
+
+                unsigned long long sequence = slot._sequence.load( std::memory_order_acquire );
+                if ( sequence != 2 * index + 2 )
+                    continue;
+
+                Event event;
+                event._name = slot._name.load( std::memory_order_relaxed );
+                event._category = slot._category.load( std::memory_order_relaxed );
+                event._argument = slot._argument.load( std::memory_order_relaxed );
+                event._begin = slot._begin.load( std::memory_order_relaxed );
+                event._end = slot._end.load( std::memory_order_relaxed );
+
+                std::atomic_thread_fence( std::memory_order_acquire );
+                if ( slot._sequence.load( std::memory_order_relaxed ) != sequence )
+                    continue;
+
+                events.append( event );
+            }
+        }
+
+        void clear()
+        {
+            _clearedAt.store( _next.load( std::memory_order_acquire ), std::memory_order_relaxed );
+        }
+
+        unsigned long long getNumEvents() const
+        {
+            return _next.load( std::memory_order_relaxed ) - _clearedAt.load( std::memory_order_relaxed );
+        }
+
+        unsigned _threadId;
+        unsigned long long _mask;
+        Slot *_slots;
+        std::atomic<unsigned long long> _next;
+        std::atomic<unsigned long long> _clearedAt;
+        unsigned _sampleCounter;
+    };
+
+    struct Registry
+    {
+        Registry()
+            : _nextThreadId( 1 )
+        {
+        }
+
+        std::mutex _mutex;
+        Vector<ThreadBuffer *> _live;
+        List<ThreadBuffer *> _retired;
+        unsigned _nextThreadId;
+    };
+
+    Registry &getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    unsigned roundUpToPowerOfTwo( unsigned value )
+    {
+        unsigned result = 1;
+        while ( result < value && result < ( 1U << 31 ) )
+            result <<= 1;
+        return result;
+    }
+
+    /*
+      Allocates the thread's buffer on its first event, and retires it
+      when the thread exits.
+    */
+    struct ThreadRegistration
+    {
+        ThreadRegistration()
+            : _buffer( NULL )
+        {
+        }
+
+        ThreadBuffer *getBuffer()
+        {
+            if ( !_buffer )
+            {
+                Registry &registry( getRegistry() );
+                std::unique_lock<std::mutex> lock( registry._mutex );
+
+                _buffer = new ThreadBuffer( registry._nextThreadId++,
+                                            roundUpToPowerOfTwo( bufferCapacity.load( std::memory_order_relaxed ) ) );
+                registry._live.append( _buffer );
+            }
+
+            return _buffer;
+        }
+
+        ~ThreadRegistration()
+        {
+            if ( !_buffer )
+                return;
+
+            Registry &registry( getRegistry() );
+            std::unique_lock<std::mutex> lock( registry._mutex );
+
+            for ( unsigned i = 0; i < registry._live.size(); ++i )
+            {
+                if ( registry._live[i] == _buffer )
+                {
+                    registry._live[i] = registry._live.last();
+                    registry._live.popBack();
+                    break;
+                }
+            }
+
+            registry._retired.append( _buffer );
+            if ( registry._retired.size() > MAX_RETIRED_BUFFERS )
+            {
+                delete registry._retired.front();
+                registry._retired.popFront();
+            }
+        }
+
+        ThreadBuffer *_buffer;
+    };
+
+    thread_local ThreadRegistration threadRegistration;
+
+    void writeEscaped( FILE *file, const char *text )
+    {
+        if ( !text )
+            return;
+
+        for ( const char *c = text; *c; ++c )
+        {
+            if ( *c == '"' || *c == '\\' )
+                fprintf( file, "\\%c", *c );
+            else if ( (unsigned char)*c < 0x20 )
+                fprintf( file, "\\u%04x", (unsigned char)*c );
+            else
+                fputc( *c, file );
+        }
+    }
+}
+
+void TraceRecorder::enable( unsigned rate, unsigned capacity )
+{
+    samplingRate = ( rate == 0 ) ? 1 : rate;
+    bufferCapacity = ( capacity == 0 ) ? 1 : capacity;
+    OperationTimers::getNanosecondsPerTick();
+
+    _enabled = true;
+}
+
+void TraceRecorder::disable()
+{
+    _enabled = false;
+}
+
+bool TraceRecorder::sample()
+{
+    unsigned rate = samplingRate.load( std::memory_order_relaxed );
+    if ( rate <= 1 )
+        return true;
+
+    ThreadBuffer *buffer = threadRegistration.getBuffer();
+    if ( ++buffer->_sampleCounter < rate )
+        return false;
+
+    buffer->_sampleCounter = 0;
+    return true;
+}
+
+void TraceRecorder::record( const char *name,
+                            const char *category,
+                            long long argument,
+                            unsigned long long begin,
+                            unsigned long long end )
+{
+    threadRegistration.getBuffer()->write( name, category, argument, begin, end );
+}
+
+void TraceRecorder::clear()
+{
+    Registry &registry( getRegistry() );
+    std::unique_lock<std::mutex> lock( registry._mutex );
+
+    for ( auto &buffer : registry._live )
+        buffer->clear();
+
+    for ( const auto &buffer : registry._retired )
+        delete buffer;
+    registry._retired.clear();
+}
+
+unsigned long long TraceRecorder::getNumRecordedEvents()
+{
+    Registry &registry( getRegistry() );
+    std::unique_lock<std::mutex> lock( registry._mutex );
+
+    unsigned long long result = 0;
+    for ( const auto &buffer : registry._live )
+        result += buffer->getNumEvents();
+    for ( const auto &buffer : registry._retired )
+        result += buffer->getNumEvents();
+
+    return result;
+}
+
+void TraceRecorder::writeChromeTrace( const String &path )
+{
+    // Copy the events out first, so that the registry is not locked
+    // while writing the file
+    List<std::pair<unsigned, List<Event> > > threads;
+    {
+        Registry &registry( getRegistry() );
+        std::unique_lock<std::mutex> lock( registry._mutex );
+
+        for ( const auto &buffer : registry._retired )
+        {
+            threads.append( std::make_pair( buffer->_threadId, List<Event>() ) );
+            buffer->read( threads.back().second );
+        }
+
+        for ( const auto &buffer : registry._live )
+        {
+            threads.append( std::make_pair( buffer->_threadId, List<Event>() ) );
+            buffer->read( threads.back().second );
+        }
+    }
+
+    // Timestamps are in microseconds, relative to the earliest event
+    unsigned long long origin = 0;
+    bool first = true;
+    for ( const auto &thread : threads )
+    {
+        for ( const auto &event : thread.second )
+        {
+            if ( first || event._begin < origin )
+                origin = event._begin;
+            first = false;
+        }
+    }
+
+    double microsecondsPerTick = OperationTimers::getNanosecondsPerTick() / 1000;
+    int processId = getpid();
+
+    FILE *file = fopen( path.ascii(), "w" );
+    if ( !file )
+        throw CommonError( CommonError::OPEN_FAILED, path.ascii() );
+
+    fprintf( file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n" );
+
+    first = true;
+    for ( const auto &thread : threads )
+    {
+        fprintf( file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+                 "\"args\":{\"name\":\"thread %u\"}}",
+                 first ? "" : ",\n", processId, thread.first, thread.first );
+        first = false;
+
+        for ( const auto &event : thread.second )
+        {
+            fprintf( file, ",\n{\"name\":\"" );
+            writeEscaped( file, event._name );
+            fprintf( file, "\",\"cat\":\"" );
+            writeEscaped( file, event._category );
+            fprintf( file, "\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                     processId,
+                     thread.first,
+                     ( event._begin - origin ) * microsecondsPerTick,
+                     ( event._end - event._begin ) * microsecondsPerTick );
+
+            if ( event._argument != NO_ARGUMENT )
+                fprintf( file, ",\"args\":{\"value\":%lld}", event._argument );
+
+            fprintf( file, "}" );
+        }
+    }
+
+    fprintf( file, "\n]}\n" );
+
+    bool written = !ferror( file );
+    written = ( fclose( file ) == 0 ) && written;
+
+    if ( !written )
+        throw CommonError( CommonError::WRITE_FAILED, path.ascii() );
+}
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//
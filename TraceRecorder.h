@@ -0,0 +1,138 @@
+/*********************                                                        */
+/*! \file TraceRecorder.h
+** \verbatim
+** Top contributors (to current version):
+**   Derek Huang
+** This file is part of the Marabou project.
+** Copyright (c) 2016-2017 by the authors listed in the file AUTHORS
+** in the top-level source directory) and their institutional affiliations.
+** All rights reserved. See the file COPYING in the top-level source
+** directory for licensing information.\endverbatim
+**/
+
+#ifndef __TraceRecorder_h__
+#define __TraceRecorder_h__
+
+#include "MString.h"
+#include "OperationTimers.h"
+
+#include <atomic>
+
+/*
+  A timeline of solver phases, for finding stalls. A Scope records one
+  event with its begin and end time into a ring buffer owned by the
+  calling thread; writing an event never takes a lock, and each buffer
+  holds a fixed number of events, overwriting the oldest. The buffers
+  of all threads can be dumped at any time as Chrome trace-event JSON,
+  which Perfetto and chrome://tracing can display.
+
+  Event names and categories must be string literals (or otherwise
+  outlive the recorder), since only their addresses are stored.
+
+  Tracing is off until enable() is called; a disabled scope costs a
+  single relaxed load. With a sampling rate of n, only every n-th scope
+  of each thread is recorded.
+*/
+class TraceRecorder
+{
+public:
+    enum {
+        DEFAULT_BUFFER_CAPACITY = 1 << 16,
+        NO_ARGUMENT = -1,
+    };
+
+    class Scope
+    {
+    public:
+        Scope( const char *name, const char *category )
+            : _name( name )
+            , _category( category )
+            , _argument( NO_ARGUMENT )
+            , _begin( 0 )
+            , _active( false )
+        {
+            if ( TraceRecorder::enabled() )
+            {
+                _active = TraceRecorder::sample();
+                if ( _active )
+                    _begin = OperationTimers::now();
+            }
+        }
+
+        /*
+          Attach a non-negative value to the event, e.g. an iteration
+          number.
+        */
+        void setArgument( long long argument )
+        {
+            _argument = argument;
+        }
+
+        ~Scope()
+        {
+            if ( _active )
+                TraceRecorder::record( _name, _category, _argument, _begin, OperationTimers::now() );
+        }
+
+    private:
+        const char *_name;
+        const char *_category;
+        long long _argument;
+        unsigned long long _begin;
+        bool _active;
+    };
+
+    /*
+      Start recording, with the given number of events per thread and
+      sampling rate, or stop. The capacity only applies to threads that
+      record their first event afterwards.
+    */
+    static void enable( unsigned samplingRate = 1, unsigned bufferCapacity = DEFAULT_BUFFER_CAPACITY );
+    static void disable();
+
+    static bool enabled()
+    {
+        return _enabled.load( std::memory_order_relaxed );
+    }
+
+    /*
+      Drop all recorded events.
+    */
+    static void clear();
+
+    /*
+      Write the recorded events of all threads as Chrome trace-event
+      JSON. Failures cause a CommonError.
+    */
+    static void writeChromeTrace( const String &path );
+
+    /*
+      The number of events recorded since the last clear(), including
+      those that have since been overwritten.
+    */
+    static unsigned long long getNumRecordedEvents();
+
+private:
+    static std::atomic<bool> _enabled;
+
+    static bool sample();
+    static void record( const char *name,
+                        const char *category,
+                        long long argument,
+                        unsigned long long begin,
+                        unsigned long long end );
+};
+
+#define TRACE_SCOPE_NAME2( line ) __traceScope##line
+#define TRACE_SCOPE_NAME( line ) TRACE_SCOPE_NAME2( line )
+#define TRACE_SCOPE( name, category ) TraceRecorder::Scope TRACE_SCOPE_NAME( __LINE__ )( name, category )
+
+#endif // __TraceRecorder_h__
+
+//
+// Local Variables:
+// compile-command: "make -C ../.. "
+// tags-file-name: "../../TAGS"
+// c-basic-offset: 4
+// End:
+//